@@ -25,9 +25,27 @@
 
 #define CACHE_COHERENCY_LINE_SIZE 64
 
+/*
+ * Invoked once per atomic read-modify-write of the paired counters and counted pointers. Define it before including
+ * this header to account for RMWs (see test/rmw_accounting.cpp); it expands to nothing by default.
+ */
+#ifndef JPS_ATOMIC_RMW_HOOK
+#define JPS_ATOMIC_RMW_HOOK()
+#endif
+
 
 namespace jps {
 
+/*
+ * The failure order of a compare-exchange given a single order, as for std::atomic: a failed cas does not write,
+ * so it can be neither release nor acq_rel.
+ */
+constexpr std::memory_order cas_failure_order( std::memory_order order ) noexcept
+{
+    return order == std::memory_order_acq_rel? std::memory_order_acquire :
+           order == std::memory_order_release? std::memory_order_relaxed : order;
+}
+
 /*
  * Paired Counters
  */
@@ -168,17 +186,20 @@ struct atomic_paired_counter {
 
     paired_counter exchange( paired_counter desired, std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return { counter_.exchange( desired.word_, order ) };
     }
 
     bool compare_exchange_weak( paired_counter& expected, paired_counter desired,
                                 std::memory_order success, std::memory_order failure ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return counter_.compare_exchange_weak( expected.word_, desired.word_, success, failure );
     }
     bool compare_exchange_weak( paired_counter& expected, paired_counter desired,
                                 std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return counter_.compare_exchange_weak( expected.word_, desired.word_, order );
     }
     bool compare_exchange_weak_c1( int32_t& expected, int32_t desired,
@@ -231,11 +252,13 @@ struct atomic_paired_counter {
     bool compare_exchange_strong( paired_counter& expected, paired_counter desired,
                                   std::memory_order success, std::memory_order failure ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return counter_.compare_exchange_strong( expected.word_, desired.word_, success, failure );
     }
     bool compare_exchange_strong( paired_counter& expected, paired_counter desired,
                                   std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return counter_.compare_exchange_strong( expected.word_, desired.word_, order );
     }
     bool compare_exchange_strong_c1( int32_t& expected, int32_t desired,
@@ -306,22 +329,27 @@ struct atomic_paired_counter {
 
     paired_counter fetch_add( paired_counter arg, std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return counter_.fetch_add( arg.word_, order );
     }
     paired_counter fetch_sub( paired_counter arg, std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return counter_.fetch_sub( arg.word_, order );
     }
     paired_counter fetch_and( paired_counter arg, std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return counter_.fetch_and( arg.word_, order );
     }
     paired_counter fetch_or( paired_counter arg, std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return counter_.fetch_or( arg.word_, order );
     }
     paired_counter fetch_xor( paired_counter arg, std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return counter_.fetch_xor( arg.word_, order );
     }
 
@@ -467,33 +495,38 @@ struct atomic_counted_ptr {
 
     cptr_type exchange( cptr_type desired, std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return { word_.exchange( desired.word_, order ) };
     }
 
     bool compare_exchange_weak( cptr_type& expected, cptr_type desired,
                                 std::memory_order success, std::memory_order failure ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return word_.compare_exchange_weak( expected.word_, desired.word_, success, failure );
     }
     bool compare_exchange_weak( cptr_type& expected, cptr_type desired,
                                 std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return word_.compare_exchange_weak( expected.word_, desired.word_, order );
     }
     bool compare_exchange_strong( cptr_type& expected, cptr_type desired,
                                   std::memory_order success, std::memory_order failure ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return word_.compare_exchange_strong( expected.word_, desired.word_, success, failure );
     }
     bool compare_exchange_strong( cptr_type& expected, cptr_type desired,
                                   std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return word_.compare_exchange_strong( expected.word_, desired.word_, order );
     }
 
     void wait( cptr_type old, std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
-        return word_.wait( reinterpret_cast<cptr_type&>( old ), order );
+        return word_.wait( old.word_, order );
     }
     void notify_one() noexcept
     {
@@ -506,22 +539,27 @@ struct atomic_counted_ptr {
 
     cptr_type fetch_add( int16_t arg, std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return word_.fetch_add( counted_ptr<T>::make_word( arg ), order );
     }
     cptr_type fetch_sub( int16_t arg, std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return word_.fetch_sub( counted_ptr<T>::make_word( arg ), order );
     }
     cptr_type fetch_and( int16_t arg, std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return word_.fetch_and( counted_ptr<T>::make_word( arg, reinterpret_cast<T*>( counted_ptr<T>::ptr_mask )), order );
     }
     cptr_type fetch_or( int16_t arg, std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return word_.fetch_or( counted_ptr<T>::make_word( arg ), order );
     }
     cptr_type fetch_xor( int16_t arg, std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
+        JPS_ATOMIC_RMW_HOOK();
         return word_.fetch_xor( counted_ptr<T>::make_word( arg ), order );
     }
 
@@ -866,6 +904,7 @@ struct shareable : private sptr_header_base<T> {
 
 private:
     void _delete_object( [[maybe_unused]] T* self ) override {
+        JPS_ATOMIC_RMW_HOOK();
         auto old_state = state_.fetch_or( destroying_object );
         assert( 0 == ( old_state & ( destroying_object | object_destroyed )));
 
@@ -873,6 +912,7 @@ private:
         std::destroy_at( sptr_header_base<T>::get_ptr() );
 
         // flip sptr_transition_state from destroying -> destroyed
+        JPS_ATOMIC_RMW_HOOK();
         old_state = state_.fetch_xor( destroying_object | object_destroyed );
         assert( destroying_object == ( old_state & ( destroying_object | object_destroyed )));
 
@@ -885,6 +925,7 @@ private:
 
     void _delete_header() override {
         // mark our intention to destroy the header
+        JPS_ATOMIC_RMW_HOOK();
         auto old_state = state_.fetch_or( destroy_header );
         assert( old_state & ( destroying_object | object_destroyed ));
 
@@ -1105,10 +1146,12 @@ public:
         cp_header_ = { 0, r.cp_header_.get_ptr() };
         if( cp_header_.get_ptr() )
             cp_header_->acquire_weak( std::memory_order_relaxed );
+        return *this;
     }
     weak_ptr& operator=( weak_ptr&& r )
     {
         swap( r );
+        return *this;
     }
 
     void reset()
@@ -1317,12 +1360,12 @@ start:
     bool compare_exchange_weak( shared_ptr<T>& expected, const shared_ptr<T>& desired,
                                 std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
-        return compare_exchange_weak( expected, desired, order, order );
+        return compare_exchange_weak( expected, desired, order, cas_failure_order( order ));
     }
     bool compare_exchange_weak( shared_ptr<T>& expected, shared_ptr<T>&& desired,
                                 std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
-        return compare_exchange_weak( expected, std::move( desired ), order, order );
+        return compare_exchange_weak( expected, std::move( desired ), order, cas_failure_order( order ));
     }
 
 
@@ -1407,19 +1450,19 @@ start:
     bool compare_exchange_strong( shared_ptr<T>& expected, const shared_ptr<T>& desired,
                                   std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
-        return compare_exchange_strong( expected, desired, order, order );
+        return compare_exchange_strong( expected, desired, order, cas_failure_order( order ));
     }
     bool compare_exchange_strong( shared_ptr<T>& expected, shared_ptr<T>&& desired,
                                   std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
-        return compare_exchange_strong( expected, std::move( desired ), order, order );
+        return compare_exchange_strong( expected, std::move( desired ), order, cas_failure_order( order ));
     }
 
     void wait( shared_ptr<T> old, std::memory_order order = std::memory_order_seq_cst ) noexcept
     {
-        const auto cur_ctrl = _enter( order );
+        auto cur_ctrl = _enter( order );
         for(;;) {
-            if( cur_ctrl.get_ptr() == old.get() )
+            if( cur_ctrl.get_ptr() == old.cp_header_.get_ptr() )
                 cptr_hdr_.wait( cur_ctrl );
             else {
                 _leave( cur_ctrl, std::memory_order_relaxed );
@@ -0,0 +1,382 @@
+//
+// Simple atomic shared pointers to compare against: one mutex per pointer, a pool of striped spinlocks shared by all
+// pointers (the approach of libstdc++'s atomic_load/atomic_store for std::shared_ptr), and a lock-free one protecting
+// a box holding the std::shared_ptr with hazard pointers.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*
+ * Invoked inside the critical sections of the locked pointers and between publishing and validating a hazard pointer,
+ * i.e. where a preempted thread holds up the others or an object; expands to nothing by default.
+ */
+#ifndef JPS_BASELINE_PREEMPTION_HOOK
+#define JPS_BASELINE_PREEMPTION_HOOK()
+#endif
+
+
+namespace jps::baseline {
+
+/*
+ * Whether a and b share ownership of the same object, as required of the expected value by compare_exchange.
+ */
+template<class T>
+bool equivalent( const std::shared_ptr<T>& a, const std::shared_ptr<T>& b ) noexcept
+{
+    return a == b && !a.owner_before( b ) && !b.owner_before( a );
+}
+
+/*
+ * An atomic shared pointer guarded by the lock locks.get( this ). The memory orders are accepted for compatibility
+ * only; every operation is sequentially consistent. Replaced values are destroyed after the lock is released.
+ */
+template<class T, class Locks>
+class locked_atomic_shared_ptr {
+public:
+    using value_type = std::shared_ptr<T>;
+    static constexpr bool is_always_lock_free = false;
+
+    locked_atomic_shared_ptr() = default;
+    locked_atomic_shared_ptr( const locked_atomic_shared_ptr& ) = delete;
+    locked_atomic_shared_ptr& operator=( const locked_atomic_shared_ptr& ) = delete;
+
+    value_type load( std::memory_order = std::memory_order_seq_cst ) const
+    {
+        std::lock_guard lock( locks_.get( this ));
+        JPS_BASELINE_PREEMPTION_HOOK();
+        return ptr_;
+    }
+    void store( value_type desired, std::memory_order = std::memory_order_seq_cst )
+    {
+        {
+            std::lock_guard lock( locks_.get( this ));
+            JPS_BASELINE_PREEMPTION_HOOK();
+            ptr_.swap( desired );
+        }
+    }
+    value_type exchange( value_type desired, std::memory_order = std::memory_order_seq_cst )
+    {
+        {
+            std::lock_guard lock( locks_.get( this ));
+            JPS_BASELINE_PREEMPTION_HOOK();
+            ptr_.swap( desired );
+        }
+        return desired;
+    }
+
+    bool compare_exchange_strong( value_type& expected, value_type desired,
+                                  std::memory_order, std::memory_order )
+    {
+        value_type old;
+        std::lock_guard lock( locks_.get( this ));
+        JPS_BASELINE_PREEMPTION_HOOK();
+        if( equivalent( ptr_, expected )) {
+            old = std::move( ptr_ );
+            ptr_ = std::move( desired );
+            return true;
+        }
+        old = std::exchange( expected, ptr_ );
+        return false;
+    }
+    bool compare_exchange_strong( value_type& expected, value_type desired,
+                                  std::memory_order order = std::memory_order_seq_cst )
+    {
+        return compare_exchange_strong( expected, std::move( desired ), order, order );
+    }
+    bool compare_exchange_weak( value_type& expected, value_type desired,
+                                std::memory_order success, std::memory_order failure )
+    {
+        return compare_exchange_strong( expected, std::move( desired ), success, failure );
+    }
+    bool compare_exchange_weak( value_type& expected, value_type desired,
+                                std::memory_order order = std::memory_order_seq_cst )
+    {
+        return compare_exchange_strong( expected, std::move( desired ), order, order );
+    }
+
+private:
+    mutable Locks locks_;
+    value_type ptr_;
+};
+
+struct own_mutex {
+    std::mutex& get( const void* ) noexcept
+    {
+        return mutex_;
+    }
+    std::mutex mutex_;
+};
+
+/*
+ * Test-and-test-and-set spinlock.
+ */
+class alignas( 64 ) spin_lock {
+public:
+    void lock() noexcept
+    {
+        while( locked_.exchange( true, std::memory_order_acquire ))
+            while( locked_.load( std::memory_order_relaxed ))
+                _pause();
+    }
+    void unlock() noexcept
+    {
+        locked_.store( false, std::memory_order_release );
+    }
+
+private:
+    static void _pause() noexcept
+    {
+#if defined( __x86_64__ ) || defined( __i386__ )
+        __builtin_ia32_pause();
+#endif
+    }
+
+    std::atomic<bool> locked_{ false };
+};
+
+/*
+ * A fixed pool of spinlocks shared by all pointers; the pointer's address selects the lock.
+ */
+struct striped_spin_locks {
+    static constexpr size_t n_stripes = 16;
+
+    spin_lock& get( const void* p ) const noexcept
+    {
+        static spin_lock stripes[n_stripes];
+        return stripes[( reinterpret_cast<uintptr_t>( p ) * 0x9e3779b97f4a7c15ull ) >> 60];
+    }
+};
+
+template<class T>
+class mutex_atomic_shared_ptr : public locked_atomic_shared_ptr<T, own_mutex> {};
+
+template<class T>
+class striped_atomic_shared_ptr : public locked_atomic_shared_ptr<T, striped_spin_locks> {};
+
+/*
+ * A single hazard pointer per thread, taken on first use from a lock-free list of slots that grows by one slot
+ * whenever all are taken (so there is no limit on the number of threads) and returned at thread exit, and the objects
+ * retired by the thread, deleted once no hazard pointer protects them.
+ */
+class hazard_pointers {
+public:
+    static constexpr size_t retire_threshold = 2*64;
+
+    static hazard_pointers& local()
+    {
+        static thread_local hazard_pointers hp;
+        return hp;
+    }
+
+    std::atomic<const void*>& hazard() noexcept
+    {
+        return slot_->hazard;
+    }
+
+    template<class Box>
+    void retire( Box* b )
+    {
+        if( !b )
+            return;
+        retired_.push_back( { b, []( void* p ) { delete static_cast<Box*>( p ); } } );
+        if( retired_.size() >= retire_threshold )
+            _scan();
+    }
+
+private:
+    struct alignas( 64 ) slot {
+        std::atomic<const void*> hazard{ nullptr };
+        std::atomic<bool> used{ true };
+        slot* next = nullptr;
+    };
+    struct retired {
+        void* p;
+        void ( *destroy )( void* );
+    };
+
+    /*
+     * The slots, newest first; they are only ever added, and deleted at exit.
+     */
+    struct slot_list {
+        std::atomic<slot*> head{ nullptr };
+        ~slot_list()
+        {
+            for( auto s = head.load(); s; )
+                delete std::exchange( s, s->next );
+        }
+    };
+    static slot_list& _slots()
+    {
+        static slot_list slots;
+        return slots;
+    }
+
+    hazard_pointers()
+    {
+        auto& head = _slots().head;
+        for( auto s = head.load( std::memory_order_acquire ); s; s = s->next ) {
+            if( !s->used.exchange( true, std::memory_order_acquire )) {
+                slot_ = s;
+                return;
+            }
+        }
+        slot_ = new slot;
+        slot_->next = head.load( std::memory_order_relaxed );
+        // seq_cst like the hazard pointers, so that a scan after the thread's first hazard pointer sees the slot
+        while( !head.compare_exchange_weak( slot_->next, slot_, std::memory_order_seq_cst, std::memory_order_relaxed ))
+            ;
+    }
+    ~hazard_pointers()
+    {
+        while( !retired_.empty() ) {
+            _scan();
+            if( !retired_.empty() )
+                std::this_thread::yield();
+        }
+        slot_->used.store( false, std::memory_order_release );
+    }
+
+    void _scan()
+    {
+        std::vector<const void*> protected_ptrs;
+        for( auto s = _slots().head.load( std::memory_order_seq_cst ); s; s = s->next )
+            if( const auto p = s->hazard.load( std::memory_order_seq_cst ))
+                protected_ptrs.push_back( p );
+        std::sort( protected_ptrs.begin(), protected_ptrs.end() );
+
+        auto keep = retired_.begin();
+        for( auto& r: retired_ ) {
+            if( std::binary_search( protected_ptrs.begin(), protected_ptrs.end(), r.p ))
+                *keep++ = r;
+            else
+                r.destroy( r.p );
+        }
+        retired_.erase( keep, retired_.end() );
+    }
+
+    slot* slot_ = nullptr;
+    std::vector<retired> retired_;
+};
+
+/*
+ * A lock-free atomic shared pointer: the std::shared_ptr lives in an immutable box, the box pointer is swapped
+ * atomically, and readers protect the box by a hazard pointer while copying the std::shared_ptr out of it.
+ * Every store allocates a box. The memory orders are accepted for compatibility only.
+ */
+template<class T>
+class hazard_atomic_shared_ptr {
+public:
+    using value_type = std::shared_ptr<T>;
+    static constexpr bool is_always_lock_free = false;     // relies on the allocator
+
+    hazard_atomic_shared_ptr() = default;
+    hazard_atomic_shared_ptr( const hazard_atomic_shared_ptr& ) = delete;
+    hazard_atomic_shared_ptr& operator=( const hazard_atomic_shared_ptr& ) = delete;
+    ~hazard_atomic_shared_ptr()
+    {
+        delete box_.load( std::memory_order_relaxed );
+    }
+
+    value_type load( std::memory_order = std::memory_order_seq_cst ) const
+    {
+        auto& hazard = hazard_pointers::local().hazard();
+        const auto b = _protect( hazard );
+        value_type result = b? b->ptr : nullptr;
+        hazard.store( nullptr, std::memory_order_release );
+        return result;
+    }
+    void store( value_type desired, std::memory_order = std::memory_order_seq_cst )
+    {
+        const auto old = box_.exchange( _make_box( std::move( desired )), std::memory_order_acq_rel );
+        hazard_pointers::local().retire( old );
+    }
+    value_type exchange( value_type desired, std::memory_order = std::memory_order_seq_cst )
+    {
+        const auto old = box_.exchange( _make_box( std::move( desired )), std::memory_order_acq_rel );
+        value_type result = old? old->ptr : nullptr;   // readers may still copy from the box
+        hazard_pointers::local().retire( old );
+        return result;
+    }
+
+    bool compare_exchange_strong( value_type& expected, value_type desired,
+                                  std::memory_order, std::memory_order )
+    {
+        auto& hp = hazard_pointers::local();
+        auto& hazard = hp.hazard();
+        box* desired_box = nullptr;
+        for(;;) {
+            auto cur = _protect( hazard );
+            const value_type& cur_ptr = cur? cur->ptr : empty_;
+            if( !equivalent( cur_ptr, expected )) {
+                expected = cur_ptr;
+                hazard.store( nullptr, std::memory_order_release );
+                delete desired_box;
+                return false;
+            }
+
+            if( !desired_box && desired )
+                desired_box = new box{ std::move( desired ) };
+            if( box_.compare_exchange_strong( cur, desired_box, std::memory_order_acq_rel )) {
+                hazard.store( nullptr, std::memory_order_release );
+                hp.retire( cur );
+                return true;
+            }
+        }
+    }
+    bool compare_exchange_strong( value_type& expected, value_type desired,
+                                  std::memory_order order = std::memory_order_seq_cst )
+    {
+        return compare_exchange_strong( expected, std::move( desired ), order, order );
+    }
+    bool compare_exchange_weak( value_type& expected, value_type desired,
+                                std::memory_order success, std::memory_order failure )
+    {
+        return compare_exchange_strong( expected, std::move( desired ), success, failure );
+    }
+    bool compare_exchange_weak( value_type& expected, value_type desired,
+                                std::memory_order order = std::memory_order_seq_cst )
+    {
+        return compare_exchange_strong( expected, std::move( desired ), order, order );
+    }
+
+private:
+    struct box {
+        value_type ptr;
+    };
+
+    static box* _make_box( value_type p )
+    {
+        return p? new box{ std::move( p ) } : nullptr;
+    }
+
+    /*
+     * Publishes the current box in the hazard pointer and returns it once it is still current afterwards.
+     */
+    box* _protect( std::atomic<const void*>& hazard ) const
+    {
+        auto b = box_.load( std::memory_order_acquire );
+        for(;;) {
+            hazard.store( b, std::memory_order_seq_cst );
+            JPS_BASELINE_PREEMPTION_HOOK();
+            const auto again = box_.load( std::memory_order_seq_cst );
+            if( again == b )
+                return b;
+            b = again;
+        }
+    }
+
+    inline static const value_type empty_;
+    std::atomic<box*> box_{ nullptr };
+};
+
+}
@@ -0,0 +1,92 @@
+//
+// Asserts that the compare_exchange overloads of atomic_shared_ptr taking a single memory order derive a valid failure
+// order from it, as std::atomic does: a failed cas does not write, so its order can be neither release nor acq_rel.
+// Built with -Werror=invalid-memory-model, so that passing such an order through to std::atomic fails to compile.
+//
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include "shared_ptr.h"
+
+
+struct test {
+    test( uint64_t u ) : u{ u }
+    {}
+    uint64_t u;
+};
+
+using sptr = jps::shared_ptr<test>;
+using asptr = jps::atomic_shared_ptr<test>;
+
+static_assert( jps::cas_failure_order( std::memory_order_relaxed ) == std::memory_order_relaxed );
+static_assert( jps::cas_failure_order( std::memory_order_acquire ) == std::memory_order_acquire );
+static_assert( jps::cas_failure_order( std::memory_order_release ) == std::memory_order_relaxed );
+static_assert( jps::cas_failure_order( std::memory_order_acq_rel ) == std::memory_order_acquire );
+static_assert( jps::cas_failure_order( std::memory_order_seq_cst ) == std::memory_order_seq_cst );
+
+size_t n_failed = 0;
+
+void expect( const char* name, bool ok )
+{
+    if( !ok ) {
+        ++n_failed;
+        std::cout << "FAILED: " << name << "\n";
+    }
+    else
+        std::cout << "ok: " << name << "\n";
+}
+
+/*
+ * A cas with the given order fails against a different expected value (loading the current one into it) and then
+ * succeeds with it.
+ */
+template<class Cas>
+void expect_cas( const char* name, Cas cas )
+{
+    asptr a;
+    const sptr current{ new test{ 1 }};
+    a.store( current );
+
+    sptr expected{ new test{ 2 }};
+    const auto failed = !cas( a, expected, sptr{ new test{ 3 }} ) && expected == current;
+    const auto succeeded = cas( a, expected, sptr{ new test{ 4 }} ) && a.load()->u == 4;
+    expect( name, failed && succeeded );
+}
+
+int main()
+{
+    expect_cas( "compare_exchange_strong( release )", []( asptr& a, sptr& e, sptr d ) {
+        return a.compare_exchange_strong( e, std::move( d ), std::memory_order_release );
+    } );
+    expect_cas( "compare_exchange_strong( acq_rel )", []( asptr& a, sptr& e, sptr d ) {
+        return a.compare_exchange_strong( e, std::move( d ), std::memory_order_acq_rel );
+    } );
+    expect_cas( "compare_exchange_strong( const&, release )", []( asptr& a, sptr& e, sptr d ) {
+        return a.compare_exchange_strong( e, d, std::memory_order_release );
+    } );
+    expect_cas( "compare_exchange_strong( const&, acq_rel )", []( asptr& a, sptr& e, sptr d ) {
+        return a.compare_exchange_strong( e, d, std::memory_order_acq_rel );
+    } );
+    // a weak cas may fail spuriously; retry until the value tells
+    expect_cas( "compare_exchange_weak( release )", []( asptr& a, sptr& e, sptr d ) {
+        const auto before = e;
+        while( !a.compare_exchange_weak( e, d, std::memory_order_release ))
+            if( e != before )
+                return false;
+        return true;
+    } );
+    expect_cas( "compare_exchange_weak( acq_rel )", []( asptr& a, sptr& e, sptr d ) {
+        const auto before = e;
+        while( !a.compare_exchange_weak( e, std::move( d ), std::memory_order_acq_rel ))
+            if( e != before )
+                return false;
+        return true;
+    } );
+
+    if( n_failed ) {
+        std::cout << n_failed << " test(s) failed\n";
+        return 1;
+    }
+    return 0;
+}
@@ -4,13 +4,19 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <chrono>
 #include <thread>
 #include <atomic>
 #include <latch>
 #include <barrier>
+#include "histogram.h"
+#include "perf_counters.h"
+#include "topology.h"
+#include "worker_pool.h"
 
 
 namespace jps {
@@ -24,74 +30,139 @@ public:
             sync_( n_workers + 1 ),
             run_time_( run_time ),
             warmup_time_( warmup_time ),
-            continue_( true ),
             worker_scores_( n_workers )
     {}
 
     template<typename TestFunction>
     size_t run( const TestFunction& test_function ) {
-        // start workers
-        for( auto i = 0u; i < n_workers_; ++i ) {
-            worker_scores_[i].hits.store( 0, std::memory_order_release );
-            workers_.emplace_back( [&]( size_t worker_id ) {
-                _get_worker_id() = worker_id;
-
-                // synchronize with other workers
-                sync_.arrive_and_wait();
-
-                // go until we're supposed to stop
-                while( continue_.test( std::memory_order_release )) {
-                    test_function();
-                    worker_scores_[worker_id].hits.fetch_add( 1, std::memory_order_seq_cst );
-                }
-            }, i );
-        }
-
-        return _run_and_finis();
+        return _run( [&] { test_function(); } );
     }
     template<class Derived>
     size_t run( void( Derived::*test_function )() ) {
         static_assert( std::is_base_of_v<experiment, Derived> );
 
-        // start workers
-        for( auto i = 0u; i < n_workers_; ++i ) {
-            worker_scores_[i].hits.store( 0, std::memory_order_seq_cst );
-            workers_.emplace_back( [&]( size_t worker_id ) {
-                _get_worker_id() = worker_id;
-
-                // synchronize with other workers
-                sync_.arrive_and_wait();
-
-                // go until we're supposed to stop
-                while( continue_.test( std::memory_order_seq_cst )) {
-                    ( static_cast<Derived*>( this )->*test_function )();
-                    worker_scores_[worker_id].hits.fetch_add( 1, std::memory_order_seq_cst );
-                }
-            }, i );
-        }
-
-        return _run_and_finis();
+        return _run( [&] { ( static_cast<Derived*>( this )->*test_function )(); } );
     }
     template<class C>
     size_t run( C* c, void( C::*test_function )() ) {
-        // start workers
-        for( auto i = 0u; i < n_workers_; ++i ) {
-            worker_scores_[i].hits.store( 0, std::memory_order_release );
-            workers_.emplace_back( [&]( size_t worker_id ) {
-                _get_worker_id() = worker_id;
-
-                // synchronize with other workers
-                sync_.arrive_and_wait();
-
-                // go until we're supposed to stop
-                while( continue_.test( std::memory_order_release )) {
-                    c->*test_function();
-                    worker_scores_[worker_id].hits.fetch_add( 1, std::memory_order_seq_cst );
-                }
-            }, i );
-        }
+        return _run( [&] { ( c->*test_function )(); } );
+    }
 
-        return _run_and_finis();
+    /*
+     * Enables latency sampling: every n-th call of the test function (per worker) is timed. 0 disables sampling.
+     * Must be called before run().
+     */
+    void sample_latency( size_t every_nth ) {
+        sample_every_ = every_nth;
+    }
+    /*
+     * Number of calls of the test function between two checks whether to stop (default: 16). The counts are
+     * kept locally by each worker and only published at the end of the warm-up and of the measured window.
+     * Must be called before run().
+     */
+    void check_every( size_t ops_per_check ) {
+        ops_per_check_ = ops_per_check? ops_per_check : 1;
+    }
+    /*
+     * Runs the workers on the threads of the given pool instead of starting new threads. Must be called before run().
+     */
+    void use_pool( worker_pool& pool ) {
+        pool_ = &pool;
+    }
+    /*
+     * Pins worker i to cpus[i % cpus.size()] (aborting if that fails); an empty list leaves the placement to the
+     * scheduler. Must be called before run().
+     */
+    void pin( const std::vector<int>& cpus ) {
+        cpus_ = cpus;
+    }
+    /*
+     * Ends the warm-up once the throughput has become steady instead of after the fixed warm-up time: the progress of
+     * the workers is sampled every period, and the warm-up ends when the throughputs of the last window periods
+     * differ by at most rel_tolerance of their mean, but not before the warm-up time given to the constructor and
+     * not after max_warmup. A rel_tolerance of 0 restores the fixed warm-up. Must be called before run().
+     */
+    void detect_steady_state( double rel_tolerance, size_t window = 5,
+                              std::chrono::milliseconds period = std::chrono::milliseconds( 10 ),
+                              std::chrono::milliseconds max_warmup = std::chrono::milliseconds( 1000 )) {
+        steady_tolerance_ = rel_tolerance;
+        steady_window_ = std::max<size_t>( window, 2 );
+        sample_period_ = std::max( period, std::chrono::milliseconds( 1 ));
+        max_warmup_time_ = max_warmup;
+    }
+    /*
+     * Records the progress (calls so far) of every worker every period during warm-up and measured window, see
+     * progress_samples(). Must be called before run().
+     */
+    void record_progress( std::chrono::milliseconds period ) {
+        record_progress_ = period.count() > 0;
+        if( record_progress_ )
+            sample_period_ = period;
+    }
+    /*
+     * Tracks the longest stall of each worker, see worker_max_stalls_ns(); costs a ticks() per batch of calls.
+     * Must be called before run().
+     */
+    void track_stalls( bool on ) {
+        track_stalls_ = on;
+    }
+    /*
+     * Counts the given hardware events per worker during the measured window. Must be called before run().
+     */
+    void count_perf_events( const std::vector<perf_event_spec>& events ) {
+        perf_events_ = events;
+    }
+    /*
+     * The hardware event counts of the measured window summed over all workers, in the order given to
+     * count_perf_events(); nullopt if an event was unavailable for any worker.
+     */
+    const std::vector<std::optional<double>>& perf_totals() const {
+        return perf_totals_;
+    }
+    /*
+     * The latencies of the sampled calls during the measured window (i.e. without warm-up), merged over all workers,
+     * in ticks; see ticks_per_ns() for the conversion.
+     */
+    const log_histogram& latencies() const {
+        return latencies_;
+    }
+    double ticks_per_ns() const {
+        return ticks_per_ns_;
+    }
+    struct progress_sample {
+        double ms;                  ///< since the start of the warm-up
+        bool measuring;
+        std::vector<size_t> hits;   ///< calls per worker so far (including the warm-up)
+    };
+    const std::vector<progress_sample>& progress_samples() const {
+        return progress_;
+    }
+    /*
+     * The time the warm-up actually took.
+     */
+    std::chrono::duration<double, std::milli> warmup_time_used() const {
+        return warmup_used_;
+    }
+    /*
+     * The number of calls of the test function of each worker during the measured window.
+     */
+    std::vector<double> worker_hits() const {
+        std::vector<double> hits;
+        for( auto& score: worker_scores_ )
+            hits.push_back( double( score.hits.load( std::memory_order_acquire )
+                                    - score.warmup_hits.load( std::memory_order_acquire )));
+        return hits;
+    }
+    /*
+     * The longest interval of each worker during the measured window in which it did not complete a batch of
+     * calls (see check_every()), in ns; i.e. a lower bound of the time it made no progress. 0 unless tracked, see
+     * track_stalls().
+     */
+    std::vector<double> worker_max_stalls_ns() const {
+        std::vector<double> stalls;
+        for( auto& score: worker_scores_ )
+            stalls.push_back( double( score.max_stall ) / ticks_per_ns_ );
+        return stalls;
     }
 
 protected:
@@ -100,42 +171,263 @@ protected:
     static size_t get_worker_id() {
         return _get_worker_id();
     }
+    /*
+     * Whether this is the worker's first call of the test function in the current run, i.e. when the test function
+     * has to reset its function-local thread_local state: the threads of a pool run one experiment after another.
+     */
+    static bool first_call() {
+        if( _first_call() ) [[unlikely]] {
+            _first_call() = false;
+            return true;
+        }
+        return false;
+    }
 
 private:
     static size_t& _get_worker_id() {
         static thread_local size_t worker_id;
         return worker_id;
     }
+    static bool& _first_call() {
+        static thread_local bool first;
+        return first;
+    }
+
+    template<typename Shoot>
+    size_t _run( Shoot shoot ) {
+        for( auto i = 0u; i < n_workers_; ++i ) {
+            worker_scores_[i].warmup_hits.store( 0, std::memory_order_relaxed );
+            worker_scores_[i].hits.store( 0, std::memory_order_relaxed );
+            worker_scores_[i].max_stall = 0;
+            worker_scores_[i].progress.store( 0, std::memory_order_relaxed );
+        }
+
+        const auto work = [this, shoot]( size_t worker_id ) {
+            _get_worker_id() = worker_id;
+            _first_call() = true;
+            if( !cpus_.empty() )
+                pin_worker( worker_id, cpus_[worker_id % cpus_.size()] );
+            auto& score = worker_scores_[worker_id];
+            if( !perf_events_.empty() )
+                score.perf.open( perf_events_ );
+            const auto sample_every = sample_every_;
+            const auto ops_per_check = ops_per_check_;
+            // the bookkeeping per batch only if asked for: the progress for steady-state detection during the warm-up
+            // and for record_progress(), the stalls for track_stalls()
+            auto track_progress = record_progress_ || steady_tolerance_ > 0.;
+            const auto track_stalls = track_stalls_;
+            size_t since_sample = 0;
+            size_t hits = 0;
+            uint64_t max_stall = 0;
+
+            // synchronize with other workers
+            sync_.arrive_and_wait();
+            uint64_t last_batch = ticks();
+
+            // go until we're supposed to stop, counting locally and checking the phase every ops_per_check calls
+            auto phase = phase_.load( std::memory_order_acquire );
+            for(;;) {
+                if( sample_every ) [[unlikely]] {
+                    for( auto k = 0u; k < ops_per_check; ++k ) {
+                        if( ++since_sample == sample_every ) [[unlikely]] {
+                            since_sample = 0;
+                            if( phase == measuring ) {
+                                const auto t1 = ticks();
+                                shoot();
+                                const auto t2 = ticks();
+                                score.latencies.record( t2-t1 );
+                                continue;
+                            }
+                        }
+                        shoot();
+                    }
+                }
+                else {
+                    for( auto k = 0u; k < ops_per_check; ++k )
+                        shoot();
+                }
+                hits += ops_per_check;
+                if( track_progress || track_stalls ) [[unlikely]] {
+                    if( track_progress )
+                        score.progress.store( hits, std::memory_order_relaxed );
+
+                    // the longest time between two completed batches while measuring
+                    if( track_stalls ) {
+                        const auto now = ticks();
+                        if( phase == measuring && now - last_batch > max_stall )
+                            max_stall = now - last_batch;
+                        last_batch = now;
+                    }
+                }
+
+                // publish the hits at the phase boundaries only
+                const auto cur_phase = phase_.load( std::memory_order_acquire );
+                if( cur_phase != phase ) [[unlikely]] {
+                    if( phase == warming_up ) {
+                        score.warmup_hits.store( hits, std::memory_order_release );
+                        track_progress = record_progress_;
+                        // the stalls count from the start of the measured window
+                        if( track_stalls )
+                            last_batch = ticks();
+                    }
+                    if( cur_phase == stopped ) {
+                        score.max_stall = max_stall;
+                        score.hits.store( hits, std::memory_order_release );
+                        break;
+                    }
+                    phase = cur_phase;
+                }
+            }
+        };
+
+        // start workers
+        if( pool_ )
+            pool_->start( n_workers_, work );
+        else {
+            for( auto i = 0u; i < n_workers_; ++i )
+                workers_.emplace_back( work, i );
+        }
+
+        return _run_and_finis();
+    }
+
     size_t _run_and_finis() {
         // synchronize with workers
         std::this_thread::yield();
         sync_.arrive_and_wait();
 
         // let the threads start and warm up (e.g. converge in their caching behaviour)
-        std::this_thread::sleep_for( warmup_time_ );
-        size_t warmup_result = 0;
+        const auto start = std::chrono::steady_clock::now();
+        progress_.clear();
+        _warm_up( start );
+        warmup_used_ = std::chrono::steady_clock::now() - start;
+        phase_.store( measuring, std::memory_order_release );
         for( auto i = 0u; i < n_workers_; ++i )
-            warmup_result += worker_scores_[i].hits.load( std::memory_order_acquire );
+            worker_scores_[i].perf.enable();
+        const auto ticks1 = ticks();
+        const auto time1 = std::chrono::steady_clock::now();
 
         // let the workers do their job
-        std::this_thread::sleep_for( run_time_ );
+        if( record_progress_ ) {
+            const auto end = time1 + std::chrono::duration_cast<std::chrono::steady_clock::duration>( run_time_ );
+            for( auto next = time1 + sample_period_; next < end; next += sample_period_ ) {
+                std::this_thread::sleep_until( next );
+                _sample_progress( start, true );
+            }
+            std::this_thread::sleep_until( end );
+        }
+        else
+            std::this_thread::sleep_for( run_time_ );
 
-        // notify to finish the execution and gather the results
-        continue_.clear( std::memory_order_release );
-        size_t result = 0;
+        // notify to finish the execution
         for( auto i = 0u; i < n_workers_; ++i )
-            result += worker_scores_[i].hits.load( std::memory_order_acquire );
-        result -= warmup_result;
+            worker_scores_[i].perf.disable();
+        const auto ticks2 = ticks();
+        const auto time2 = std::chrono::steady_clock::now();
+        phase_.store( stopped, std::memory_order_release );
 
-        // wait for workers to finish
+        // wait for workers to finish and gather the results
+        if( pool_ )
+            pool_->wait();
         for( auto& w: workers_ )
             w.join();
+        size_t result = 0;
+        for( auto i = 0u; i < n_workers_; ++i )
+            result += worker_scores_[i].hits.load( std::memory_order_acquire )
+                      - worker_scores_[i].warmup_hits.load( std::memory_order_acquire );
+
+        // merge the latencies of all workers
+        const std::chrono::duration<double, std::nano> elapsed = time2 - time1;
+        ticks_per_ns_ = double( ticks2-ticks1 ) / elapsed.count();
+        latencies_.clear();
+        for( auto i = 0u; i < n_workers_; ++i )
+            latencies_.merge( worker_scores_[i].latencies );
+
+        // sum up the hardware event counts of all workers
+        perf_totals_.assign( perf_events_.size(), 0. );
+        for( auto i = 0u; i < n_workers_; ++i ) {
+            const auto values = worker_scores_[i].perf.read();
+            for( auto e = 0u; e < perf_events_.size(); ++e ) {
+                if( perf_totals_[e] && values[e] )
+                    *perf_totals_[e] += *values[e];
+                else
+                    perf_totals_[e].reset();
+            }
+        }
 
         return result;
     }
 
+    /*
+     * Sleeps for the fixed warm-up time or until the throughput is steady, see detect_steady_state().
+     */
+    void _warm_up( std::chrono::steady_clock::time_point start ) {
+        if( steady_tolerance_ <= 0. && !record_progress_ ) {
+            std::this_thread::sleep_for( warmup_time_ );
+            return;
+        }
+
+        std::vector<double> rates;
+        auto last_total = _sample_progress( start, false );
+        auto last_time = start;
+        for( auto next = start + sample_period_;; next += sample_period_ ) {
+            std::this_thread::sleep_until( next );
+            const auto now = std::chrono::steady_clock::now();
+            const auto total = _sample_progress( start, false );
+            const std::chrono::duration<double, std::micro> dt = now - last_time;
+            rates.push_back( double( total-last_total ) / dt.count() );
+            last_total = total;
+            last_time = now;
+
+            if( now - start < warmup_time_ )
+                continue;
+            if( steady_tolerance_ <= 0. || now - start >= max_warmup_time_ )
+                return;
+            if( rates.size() >= steady_window_ ) {
+                const auto [min, max] = std::minmax_element( rates.end() - long( steady_window_ ), rates.end() );
+                double mean = 0.;
+                for( auto r = rates.end() - long( steady_window_ ); r != rates.end(); ++r )
+                    mean += *r;
+                mean /= double( steady_window_ );
+                if( mean > 0. && *max - *min <= steady_tolerance_ * mean )
+                    return;
+            }
+        }
+    }
+
+    /*
+     * Returns the calls of all workers so far, recording them per worker if requested.
+     */
+    size_t _sample_progress( std::chrono::steady_clock::time_point start, bool measuring ) {
+        size_t total = 0;
+        progress_sample sample;
+        for( auto& score: worker_scores_ ) {
+            const auto hits = score.progress.load( std::memory_order_relaxed );
+            total += hits;
+            if( record_progress_ )
+                sample.hits.push_back( hits );
+        }
+        if( record_progress_ ) {
+            sample.ms = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+            sample.measuring = measuring;
+            progress_.push_back( std::move( sample ));
+        }
+        return total;
+    }
+
+    enum phase : int {
+        warming_up,
+        measuring,
+        stopped
+    };
+
     struct alignas( 128 ) worker_score {
+        std::atomic<size_t> warmup_hits;
         std::atomic<size_t> hits;
+        uint64_t max_stall = 0;     ///< in ticks
+        std::atomic<size_t> progress;   ///< calls so far, published after every batch
+        log_histogram latencies;
+        perf_counters perf;
     };
 
     std::barrier<> sync_;
@@ -143,8 +435,25 @@ private:
     std::chrono::duration<long double, std::nano> run_time_;
     std::chrono::duration<long double, std::nano> warmup_time_;
 
-    std::atomic_flag continue_;
+    std::atomic<phase> phase_{ warming_up };
     std::vector<worker_score> worker_scores_;
+
+    worker_pool* pool_ = nullptr;
+    std::vector<int> cpus_;
+    std::vector<perf_event_spec> perf_events_;
+    std::vector<std::optional<double>> perf_totals_;
+    size_t ops_per_check_ = 16;
+    size_t sample_every_ = 0;
+    log_histogram latencies_;
+    double ticks_per_ns_ = 1.;
+    double steady_tolerance_ = 0.;
+    size_t steady_window_ = 5;
+    std::chrono::milliseconds sample_period_{ 10 };
+    std::chrono::milliseconds max_warmup_time_{ 1000 };
+    bool record_progress_ = false;
+    bool track_stalls_ = false;
+    std::vector<progress_sample> progress_;
+    std::chrono::duration<double, std::milli> warmup_used_{ 0 };
 };
 
 }
@@ -0,0 +1,221 @@
+//
+// Measures the memory footprint of shared pointers created in different ways and of atomic shared pointer slots,
+// for jps, std and boost (and the baselines' slots): allocations and requested bytes per object as counted by the
+// global operator new, and bytes per object in use by the allocator and of the resident set size.
+//
+// Usage: footprint [-objects <n>] [-slots <m>]
+//
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include <boost/smart_ptr/atomic_shared_ptr.hpp>
+#include <boost/smart_ptr/make_shared.hpp>
+#include "shared_ptr.h"
+#include "baselines.h"
+#include "memory.h"
+
+
+std::atomic<size_t> n_allocations{ 0 };
+std::atomic<size_t> allocated_bytes{ 0 };
+
+void* operator new( size_t size )
+{
+    n_allocations.fetch_add( 1, std::memory_order_relaxed );
+    allocated_bytes.fetch_add( size, std::memory_order_relaxed );
+    if( auto p = std::malloc( size ? size : 1 ))
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new( size_t size, std::align_val_t alignment )
+{
+    n_allocations.fetch_add( 1, std::memory_order_relaxed );
+    allocated_bytes.fetch_add( size, std::memory_order_relaxed );
+    const auto a = static_cast<size_t>( alignment );
+    if( auto p = std::aligned_alloc( a, ( size + a - 1 ) / a * a ))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete( void* p ) noexcept
+{
+    std::free( p );
+}
+void operator delete( void* p, size_t ) noexcept
+{
+    std::free( p );
+}
+void operator delete( void* p, std::align_val_t ) noexcept
+{
+    std::free( p );
+}
+void operator delete( void* p, size_t, std::align_val_t ) noexcept
+{
+    std::free( p );
+}
+
+
+struct test {
+    test( uint64_t u ) : u{ u }
+    {}
+    uint64_t u;
+};
+
+/*
+ * Returns the memory of a shareable to the global operator delete after it destroyed itself.
+ */
+struct delete_shareable {
+    template<class P>
+    void operator()( P* p ) const noexcept
+    {
+        ::operator delete( static_cast<void*>( p ));
+    }
+};
+
+/*
+ * Deallocates a shareable created by allocate_shared with std::allocator.
+ */
+struct deallocate_shareable {
+    template<class P>
+    void operator()( P* p ) const noexcept
+    {
+        std::allocator<P>().deallocate( p, 1 );
+    }
+};
+
+/*
+ * Runs create( n ), which returns whatever keeps the n objects (or slots) alive, and prints the footprint per object.
+ * The size of the handles (e.g. a vector of shared pointers reserved beforehand) is not included unless create()
+ * allocates them itself.
+ */
+template<class Create>
+void report( const std::string& name, size_t n, size_t handle_size, Create create )
+{
+#if defined( __GLIBC__ )
+    malloc_trim( 0 );
+#endif
+    const auto allocations0 = n_allocations.load();
+    const auto bytes0 = allocated_bytes.load();
+    const auto heap0 = jps::heap_in_use_bytes();
+    const auto rss0 = jps::rss_bytes();
+
+    [[maybe_unused]] const auto keep = create( n );
+
+    const auto per_object = [n]( size_t after, size_t before ) {
+        return ( double( after ) - double( before )) / double( n );
+    };
+    std::cout << std::left << std::setw( 32 ) << name << std::right
+              << std::setw( 10 ) << handle_size
+              << std::setw( 12 ) << per_object( n_allocations.load(), allocations0 )
+              << std::setw( 12 ) << per_object( allocated_bytes.load(), bytes0 )
+              << std::setw( 12 ) << per_object( jps::heap_in_use_bytes(), heap0 )
+              << std::setw( 12 ) << per_object( jps::rss_bytes(), rss0 ) << std::endl;
+}
+
+template<class SPTR, class Make>
+void report_objects( const std::string& name, size_t n, Make make )
+{
+    std::vector<SPTR> handles;
+    handles.reserve( n );
+    report( name, n, sizeof( SPTR ), [&]( size_t n ) {
+        for( auto i = 0u; i < n; ++i )
+            handles.push_back( make( i ));
+        return 0;
+    } );
+}
+
+/*
+ * Slots are reported empty and holding one object each (created by make).
+ */
+template<class ASPTR, class Make>
+void report_slots( const std::string& name, size_t m, Make make )
+{
+    report( name + " (empty)", m, sizeof( ASPTR ), []( size_t m ) {
+        return std::make_unique<std::vector<ASPTR>>( m );
+    } );
+    report( name + " (+object)", m, sizeof( ASPTR ), [&]( size_t m ) {
+        auto slots = std::make_unique<std::vector<ASPTR>>( m );
+        for( auto i = 0u; i < m; ++i )
+            ( *slots )[i].store( make( i ));
+        return slots;
+    } );
+}
+
+int main( int argc, char* argv[] ) {
+    size_t n_objects = 1000000;
+    size_t n_slots = 1000000;
+    for( auto i = 1; i < argc; ++i ) {
+        const auto s = std::string( argv[i] );
+
+        if( s == "-objects" && i+1 < argc )
+            n_objects = std::atoi( argv[++i] );
+        else if( s == "-slots" && i+1 < argc )
+            n_slots = std::atoi( argv[++i] );
+        else {
+            std::cerr << "Unknown parameter: " << s << "\n";
+            exit( -1 );
+        }
+    }
+
+    std::cout << std::left << std::setw( 32 ) << "=== objects (" + std::to_string( sizeof( test )) + " bytes)" << std::right
+              << std::setw( 10 ) << "sizeof" << std::setw( 12 ) << "allocs" << std::setw( 12 ) << "requested"
+              << std::setw( 12 ) << "heap" << std::setw( 12 ) << "rss" << "\n";
+
+    report_objects<jps::shared_ptr<test>>( "jps make_shared", n_objects, []( size_t i ) {
+        return jps::make_shared<test>( i );
+    } );
+    report_objects<jps::shared_ptr<test>>( "jps shared_ptr( new T )", n_objects, []( size_t i ) {
+        return jps::shared_ptr<test>{ new test{ i }};
+    } );
+    report_objects<jps::shared_ptr<test>>( "jps shareable", n_objects, []( size_t i ) {
+        delete_shareable d;
+        return jps::shared_ptr<test>( *new jps::shareable<test, delete_shareable>{ d, i } );
+    } );
+    report_objects<jps::shared_ptr<test>>( "jps allocate_shared", n_objects, []( size_t i ) {
+        std::allocator<jps::shareable<test, deallocate_shareable>> alloc;
+        deallocate_shareable d;
+        return jps::allocate_shared<test>( alloc, d, i );
+    } );
+    report_objects<std::shared_ptr<test>>( "std make_shared", n_objects, []( size_t i ) {
+        return std::make_shared<test>( i );
+    } );
+    report_objects<std::shared_ptr<test>>( "std shared_ptr( new T )", n_objects, []( size_t i ) {
+        return std::shared_ptr<test>{ new test{ i }};
+    } );
+    report_objects<std::shared_ptr<test>>( "std allocate_shared", n_objects, []( size_t i ) {
+        return std::allocate_shared<test>( std::allocator<test>(), i );
+    } );
+    report_objects<boost::shared_ptr<test>>( "boost make_shared", n_objects, []( size_t i ) {
+        return boost::make_shared<test>( i );
+    } );
+    report_objects<boost::shared_ptr<test>>( "boost shared_ptr( new T )", n_objects, []( size_t i ) {
+        return boost::shared_ptr<test>{ new test{ i }};
+    } );
+
+    std::cout << "\n" << std::left << std::setw( 32 ) << "=== atomic slots" << std::right
+              << std::setw( 10 ) << "sizeof" << std::setw( 12 ) << "allocs" << std::setw( 12 ) << "requested"
+              << std::setw( 12 ) << "heap" << std::setw( 12 ) << "rss" << "\n";
+
+    report_slots<jps::atomic_shared_ptr<test>>( "jps", n_slots, []( size_t i ) {
+        return jps::make_shared<test>( i );
+    } );
+    report_slots<std::atomic<std::shared_ptr<test>>>( "std", n_slots, []( size_t i ) {
+        return std::make_shared<test>( i );
+    } );
+    report_slots<boost::atomic_shared_ptr<test>>( "boost", n_slots, []( size_t i ) {
+        return boost::make_shared<test>( i );
+    } );
+    report_slots<jps::baseline::mutex_atomic_shared_ptr<test>>( "mutex", n_slots, []( size_t i ) {
+        return std::make_shared<test>( i );
+    } );
+    report_slots<jps::baseline::striped_atomic_shared_ptr<test>>( "striped", n_slots, []( size_t i ) {
+        return std::make_shared<test>( i );
+    } );
+    report_slots<jps::baseline::hazard_atomic_shared_ptr<test>>( "hazard", n_slots, []( size_t i ) {
+        return std::make_shared<test>( i );
+    } );
+}
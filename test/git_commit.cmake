@@ -0,0 +1,25 @@
+# Writes the short hash of the checked out commit to the header OUTPUT as MEASURE_GIT_COMMIT, run on every build so
+# that measure never reports a stale commit. The header is only rewritten if the commit changed, so that an unchanged
+# commit does not rebuild measure. Outside a git checkout the header is not written and measure reports "unknown".
+#
+# Expects SOURCE_DIR and OUTPUT to be set via -D.
+
+execute_process(COMMAND git rev-parse --short HEAD
+	WORKING_DIRECTORY ${SOURCE_DIR}
+	OUTPUT_VARIABLE commit
+	OUTPUT_STRIP_TRAILING_WHITESPACE
+	RESULT_VARIABLE result
+	ERROR_QUIET)
+if(NOT result EQUAL 0 OR commit STREQUAL "")
+	file(REMOVE ${OUTPUT})
+	return()
+endif()
+
+set(header "#define MEASURE_GIT_COMMIT \"${commit}\"\n")
+if(EXISTS ${OUTPUT})
+	file(READ ${OUTPUT} current)
+	if(current STREQUAL header)
+		return()
+	endif()
+endif()
+file(WRITE ${OUTPUT} "${header}")
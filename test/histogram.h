@@ -0,0 +1,126 @@
+//
+// Log-bucketed latency histogram and a cheap time stamp source for the experiments.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#endif
+
+
+namespace jps {
+
+/*
+ * Returns a monotonic time stamp in ticks. On x86 this is the TSC, elsewhere the steady clock in ns; use a
+ * calibration against the steady clock (see experiment) to convert ticks into ns.
+ */
+inline uint64_t ticks() noexcept
+{
+#if defined( __x86_64__ ) || defined( __i386__ )
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch() ).count();
+#endif
+}
+
+/*
+ * HDR-style histogram: values below 2^sub_bucket_bits are counted exactly, larger values fall into buckets of
+ * 2^sub_bucket_bits sub-buckets per power of two, i.e. the relative error is below 2^-sub_bucket_bits.
+ *
+ * Recording is not thread-safe; use one histogram per worker and merge() them afterwards.
+ */
+class log_histogram {
+public:
+    static constexpr unsigned sub_bucket_bits = 5;
+    static constexpr uint64_t sub_buckets = 1ul << sub_bucket_bits;
+    // values of up to 2^64-1, i.e. of bit widths sub_bucket_bits+1 to 64 above the exact ones
+    static constexpr size_t n_buckets = ( 65-sub_bucket_bits ) * sub_buckets;
+
+    void record( uint64_t value ) noexcept
+    {
+        ++buckets_[bucket_of( value )];
+        ++count_;
+        if( value > max_ )
+            max_ = value;
+    }
+
+    void merge( const log_histogram& r ) noexcept
+    {
+        for( auto i = 0u; i < n_buckets; ++i )
+            buckets_[i] += r.buckets_[i];
+        count_ += r.count_;
+        if( r.max_ > max_ )
+            max_ = r.max_;
+    }
+
+    void clear() noexcept
+    {
+        buckets_.fill( 0 );
+        count_ = 0;
+        max_ = 0;
+    }
+
+    uint64_t count() const noexcept
+    {
+        return count_;
+    }
+    uint64_t max() const noexcept
+    {
+        return max_;
+    }
+
+    /*
+     * Returns the highest value equivalent to the bucket containing the p-quantile, 0 <= p <= 1.
+     */
+    uint64_t percentile( double p ) const noexcept
+    {
+        if( count_ == 0 )
+            return 0;
+
+        auto rank = static_cast<uint64_t>( p * double( count_ ) + 0.5 );
+        if( rank == 0 )
+            rank = 1;
+
+        uint64_t seen = 0;
+        for( auto i = 0u; i < n_buckets; ++i ) {
+            seen += buckets_[i];
+            if( seen >= rank )
+                return std::min( highest_value_of( i ), max_ );
+        }
+        return max_;
+    }
+
+private:
+    static constexpr size_t bucket_of( uint64_t value ) noexcept
+    {
+        if( value < sub_buckets )
+            return value;
+
+        const auto shift = std::bit_width( value ) - ( sub_bucket_bits+1 );
+        return ( shift+1 ) * sub_buckets + (( value >> shift ) - sub_buckets );
+    }
+    static constexpr uint64_t highest_value_of( size_t bucket ) noexcept
+    {
+        if( bucket < sub_buckets )
+            return bucket;
+
+        const auto shift = bucket / sub_buckets - 1;
+        const auto mantissa = bucket % sub_buckets + sub_buckets;
+        return (( mantissa+1 ) << shift ) - 1;
+    }
+
+    std::array<uint64_t, n_buckets> buckets_{};
+    uint64_t count_ = 0;
+    uint64_t max_ = 0;
+};
+
+}
@@ -0,0 +1,48 @@
+//
+// Asserts that log_histogram covers the whole range of uint64_t: the largest values (e.g. negative tick differences
+// wrapped around) land in the last buckets instead of beyond them, and the percentiles keep their relative error.
+//
+
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include "histogram.h"
+
+
+size_t n_failed = 0;
+
+void expect( const char* name, bool ok )
+{
+    if( !ok ) {
+        ++n_failed;
+        std::cout << "FAILED: " << name << "\n";
+    }
+    else
+        std::cout << "ok: " << name << "\n";
+}
+
+int main()
+{
+    constexpr auto max = std::numeric_limits<uint64_t>::max();
+
+    jps::log_histogram h;
+    h.record( max );
+    expect( "record( UINT64_MAX )", h.count() == 1 && h.max() == max && h.percentile( 1. ) == max );
+
+    h.record( max/2 + 1 );
+    h.record( 1ul << 62 );
+    expect( "percentile( 0 ) of 2^62", h.percentile( 0. ) == ( 1ul << 62 ) + ( 1ul << ( 62-5 )) - 1 );
+    expect( "percentile( 0.5 ) of 2^63", h.percentile( 0.5 ) == ( 1ul << 63 ) + ( 1ul << ( 63-5 )) - 1 );
+
+    jps::log_histogram small;
+    for( uint64_t v = 0; v < 32; ++v )
+        small.record( v );
+    small.merge( h );
+    expect( "merge", small.count() == 35 && small.max() == max && small.percentile( 0.5 ) == 17 );
+
+    if( n_failed ) {
+        std::cout << n_failed << " test(s) failed\n";
+        return 1;
+    }
+    return 0;
+}
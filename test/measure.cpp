@@ -9,6 +9,8 @@
 //#define MEASURE_JSS
 //#define MEASURE_FOLLY
 #define MEASURE_JPS
+#define MEASURE_BASELINES
+#define MEASURE_BOOST
 
 #define MEASURE_STORE
 #define MEASURE_LOAD
@@ -17,14 +19,47 @@
 #define MEASURE_CAS_STRONG
 #define MEASURE_CAS_WEAK_LOOP
 #define MEASURE_CAS_STRONG_LOOP
+#define MEASURE_MIXED
+#define MEASURE_CONFIG_RELOAD
+#define MEASURE_HANDOFF
+#define MEASURE_LIST_TRAVERSAL
+#define MEASURE_COUNTER
+#define MEASURE_SPTR
+#define MEASURE_CHURN
+#define MEASURE_RECLAIM
+#define MEASURE_WAIT_NOTIFY
+#define MEASURE_PROPAGATION
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
+#include <ctime>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
 #include <memory>
+#include <new>
 #include <iostream>
+#include <sstream>
 #include <atomic>
+#include <thread>
 #include <vector>
+#include "preemption.h"
+#ifdef MEASURE_PREEMPT
+// preemption points for -preempt inside the operations of jps and of the baselines (measure_preempt only, so that
+// the libraries without preemption points are not favoured in the plain measure)
+#define JPS_ATOMIC_RMW_HOOK() jps::preemption_point()
+#define JPS_BASELINE_PREEMPTION_HOOK() jps::preemption_point()
+#endif
 #include "shared_ptr.h"
+#include "baselines.h"
 #include "experiment.h"
+#include "memory.h"
+#include "random.h"
+#include "statistics.h"
+#include "trace.h"
+#include "sweep.h"
+#include "results.h"
 
 // Anthony William's version
 //#include "jss/atomic_shared_ptr.h"
@@ -32,6 +67,10 @@
 //#include "folly/concurrency/AtomicSharedPtr.h"
 // Vladisla Tyulbashev's version
 //#include "atomic_shared_ptr.h"
+// Boost's version (spinlock based)
+#include <boost/smart_ptr/atomic_shared_ptr.hpp>
+#include <boost/smart_ptr/make_shared.hpp>
+#include <boost/smart_ptr/weak_ptr.hpp>
 
 
 using namespace std::chrono_literals;
@@ -41,6 +80,37 @@ bool measure_jss = true;
 bool measure_folly = true;
 bool measure_vtyulb = true;
 bool measure_aios = true;
+bool measure_boost = true;
+bool measure_mutex = false;
+bool measure_striped = false;
+bool measure_hazard = false;
+
+// the libraries selectable with -lib, by name; only those compiled in
+const std::pair<const char*, bool*> libraries[] = {
+#ifdef MEASURE_JPS
+        { "jps", &measure_aios },
+#endif
+#ifdef MEASURE_STD
+        { "std", &measure_std },
+#endif
+#ifdef MEASURE_JSS
+        { "jss", &measure_jss },
+#endif
+#ifdef MEASURE_FOLLY
+        { "folly", &measure_folly },
+#endif
+#ifdef MEASURE_VTYULB
+        { "vtyulb", &measure_vtyulb },
+#endif
+#ifdef MEASURE_BOOST
+        { "boost", &measure_boost },
+#endif
+#ifdef MEASURE_BASELINES
+        { "mutex", &measure_mutex },
+        { "striped", &measure_striped },
+        { "hazard", &measure_hazard },
+#endif
+};
 
 bool measure_store = true;
 bool measure_load = true;
@@ -49,6 +119,15 @@ bool measure_cas_weak = true;
 bool measure_cas_strong = true;
 bool measure_cas_weak_loop = true;
 bool measure_cas_strong_loop = true;
+bool measure_mixed = false;
+bool measure_config_reload = false;
+bool measure_handoff = false;
+bool measure_list_traversal = false;
+bool measure_counter = false;
+bool measure_churn = false;
+bool measure_reclaim = false;
+bool measure_wait_notify = false;
+bool measure_propagation = false;
 
 bool measure_with_contention = true;
 bool measure_without_contention = true;
@@ -58,26 +137,162 @@ size_t max_workers = 48;
 size_t min_vars = 1;
 size_t max_vars = 64;
 
+// if not 0 (and no -workers grid is given), sweep 1, 2, ..., oversubscribe times as many workers as cpus
+size_t oversubscribe = 0;
+
+// the swept points: explicit grids or derived from the bounds above (linear or geometric)
+std::vector<size_t> workers_grid;
+std::vector<size_t> vars_grid;
+bool geometric_grid = false;
+
+// bytes between neighbouring variables of the experiments on SptrExperiment, and the strides swept by -stride
+size_t slot_stride = 128;
+std::vector<size_t> stride_grid;
+bool sweeping_stride = false;   ///< while running the operations of SptrExperiment for each stride of the grid
+
+// persistent workers reused by all experiments, and the finished points of an interrupted sweep
+std::unique_ptr<jps::worker_pool> pool;
+jps::sweep_checkpoint checkpoint;
+// machine-readable output (appended to, so that a resumed sweep completes the files)
+std::ofstream json_out;
+std::ofstream csv_out;
+jps::run_metadata metadata;
+
+std::string current_library;
+std::string current_operation;
+bool current_contention = true;
+
+// cpus to pin the workers to in that order (empty: no pinning)
+std::string pin_policy = "none";
+std::vector<int> pin_cpus;
+
+// hardware events to count per operation (empty: no counting)
+std::vector<jps::perf_event_spec> perf_events;
+
+// the warm-up lasts at least warmup_time and ends once the throughput sampled every sample_period varies by at
+// most steady_tolerance (relative) over 5 periods, or after max_warmup_time (steady_tolerance 0: fixed warm-up)
+double steady_tolerance = 0.1;
+// report the longest stall of the workers (-stalls)
+bool measure_stalls = false;
+std::chrono::milliseconds sample_period = 10ms;
+std::chrono::milliseconds max_warmup_time = 500ms;
+// per-worker progress every sample_period (-timeseries)
+std::ofstream timeseries_out;
+
+// adaptive run length: repeat trials until the relative 95% confidence interval is below target_rel_ci
+std::chrono::milliseconds warmup_time = 20ms;
+std::chrono::milliseconds trial_time = 200ms;
+std::chrono::milliseconds max_time_per_point = 2000ms;
+double target_rel_ci = 0.02;
+size_t min_trials = 3;
+
+// the operations of e_mixed with their weights (-mix), and the distribution of their targets (-dist)
+enum mixed_op { mixed_load, mixed_store, mixed_exchange, mixed_cas, n_mixed_ops };
+const char* const mixed_op_names[n_mixed_ops] = { "load", "store", "exchange", "cas" };
+std::string mix_spec = "load=95,store=4,cas=1";
+unsigned mix_weights[n_mixed_ops] = { 95, 4, 0, 1 };
+std::string dist_spec = "uniform";
+double dist_zipf_s = 0.;
+
+// the operations on (weak) shared pointers themselves, each enabled by +<name>
+enum sptr_op { sp_copy, sp_move, sp_deref, sp_destroy, wp_construct, wp_lock, wp_expired, n_sptr_ops };
+const char* const sptr_op_names[n_sptr_ops] = {
+        "sp_copy", "sp_move", "sp_deref", "sp_destroy", "wp_construct", "wp_lock", "wp_expired" };
+bool measure_sptr_op[n_sptr_ops] = {};
+
+// size in bytes (one of churn_sizes) and destructor cost (spin iterations) of the objects published by e_churn
+constexpr size_t churn_sizes[] = { 16, 64, 256, 1024, 4096 };
+size_t churn_size = 64;
+size_t churn_dtor_work = 0;
+// memory usage samples of e_churn (-memory_trace)
+std::ofstream memory_trace;
+
+// waiters and concurrent loaders swept by +wait_notify, the rounds (store and notify_all) per point and the time
+// given to the waiters to block before each store
+std::vector<size_t> waiters_grid = { 1, 10, 100, 1000 };
+std::vector<size_t> loaders_grid = { 0, 1, 4 };
+size_t wait_rounds = 20;
+std::chrono::milliseconds wait_settle_time = 1ms;
+
+// minimum time between two stores of a writer of e_propagation (-publish_ns)
+std::chrono::nanoseconds publish_interval{ 0 };
+
+// the trace replayed by -replay, with its original timing or at maximum speed (-replay_timing)
+std::string replay_path;
+bool replay_original_timing = true;
+
+// calls between two updates by the writer of the config_reload and list_traversal scenarios (-reload_every)
+size_t reload_every = 1000;
+
+// time every n-th operation of each worker for the latency percentiles (0: no latency measurement)
+size_t latency_sample_every = 0;
+
 struct test {
     test( uint64_t u ) : u{ u }
     {}
     uint64_t u;
 };
 
+/*
+ * The distance in bytes of neighbouring objects of type T placed every stride bytes: at least sizeof( T ) and a
+ * multiple of its alignment.
+ */
+template<class T>
+constexpr size_t effective_stride( size_t stride ) {
+    return ( std::max( stride, sizeof( T )) + alignof( T ) - 1 ) / alignof( T ) * alignof( T );
+}
+
 template<class ASPTR, bool contention = true>
 class SptrExperiment : public jps::experiment
 {
 public:
     SptrExperiment( size_t n_workers, size_t n_vars, auto run_time = 1.0s ) :
-            jps::experiment( n_workers, run_time, 0.1s ),
-            atomic_sptrs_( contention? n_vars:n_workers )
+            jps::experiment( n_workers, run_time, warmup_time ),
+            atomic_sptrs_( contention? n_vars:n_workers, slot_stride )
     {}
 
 protected:
-    struct alignas( 128 ) atomic_sptr {
+    struct atomic_sptr {
         ASPTR asp_;
     };
-    std::vector<atomic_sptr> atomic_sptrs_;
+    /*
+     * The variables, one every stride bytes (see effective_stride()) from a 128 byte boundary on; with a stride
+     * below the cache line size neighbouring variables share cache lines.
+     */
+    class strided_sptrs {
+    public:
+        strided_sptrs( size_t n, size_t stride ) :
+                n_( n ),
+                stride_( effective_stride<atomic_sptr>( stride )),
+                memory_( static_cast<std::byte*>( ::operator new( n*stride_, std::align_val_t( 128 ))))
+        {
+            for( auto i = 0u; i < n_; ++i )
+                new( memory_ + i*stride_ ) atomic_sptr();
+        }
+        strided_sptrs( const strided_sptrs& ) = delete;
+        strided_sptrs& operator=( const strided_sptrs& ) = delete;
+        ~strided_sptrs()
+        {
+            for( auto i = 0u; i < n_; ++i )
+                ( *this )[i].~atomic_sptr();
+            ::operator delete( memory_, std::align_val_t( 128 ));
+        }
+
+        atomic_sptr& operator[]( size_t i ) noexcept
+        {
+            return *std::launder( reinterpret_cast<atomic_sptr*>( memory_ + i*stride_ ));
+        }
+        size_t size() const noexcept
+        {
+            return n_;
+        }
+
+    private:
+        size_t n_;
+        size_t stride_;
+        std::byte* memory_;
+    };
+    strided_sptrs atomic_sptrs_;
 };
 
 template<class SPTR, class ASPTR, bool contention = true>
@@ -90,8 +305,12 @@ public:
         return SptrExperiment<ASPTR, contention>::experiment::run( &e_store<SPTR, ASPTR, contention>::shoot );
     }
     void shoot() {
-        static thread_local SPTR sptr{ new test{ this->get_worker_id() } };
-        static thread_local size_t target = contention? 0 :this->get_worker_id();
+        static thread_local SPTR sptr;
+        static thread_local size_t target;
+        if( this->first_call() ) {
+            sptr = SPTR{ new test{ this->get_worker_id() } };
+            target = contention? 0 : this->get_worker_id();
+        }
         target = contention? ( target+1 ) % this->atomic_sptrs_.size() : this->get_worker_id();
 
         this->atomic_sptrs_[target].asp_.store( sptr, std::memory_order_release );
@@ -117,7 +336,9 @@ public:
         return SptrExperiment<ASPTR, contention>::experiment::run( &e_load<SPTR, ASPTR, contention>::shoot );
     }
     void shoot() {
-        static thread_local size_t target = contention? 0 :this->get_worker_id();
+        static thread_local size_t target;
+        if( this->first_call() )
+            target = contention? 0 : this->get_worker_id();
         if( contention )
             target = ( target+1 ) % this->atomic_sptrs_.size();
 
@@ -138,8 +359,12 @@ public:
         return SptrExperiment<ASPTR, contention>::experiment::run( &e_exchange<SPTR, ASPTR, contention>::shoot );
     }
     void shoot() {
-        static thread_local SPTR sptr{ new test{ this->get_worker_id()*2+1 } };
-        static thread_local size_t target = contention? 0 :this->get_worker_id();
+        static thread_local SPTR sptr;
+        static thread_local size_t target;
+        if( this->first_call() ) {
+            sptr = SPTR{ new test{ this->get_worker_id()*2+1 } };
+            target = contention? 0 : this->get_worker_id();
+        }
         target = contention? ( target+1 ) % this->atomic_sptrs_.size() : this->get_worker_id();
 
         sptr = this->atomic_sptrs_[target].asp_.exchange( std::move( sptr ), std::memory_order_release );
@@ -159,8 +384,12 @@ public:
         return SptrExperiment<ASPTR, contention>::experiment::run( &e_cas_weak_loop<SPTR, ASPTR, contention>::shoot );
     }
     void shoot() {
-        static thread_local SPTR sptr{ new test{ this->get_worker_id()*2+1 } };
-        static thread_local size_t target = contention? 0 :this->get_worker_id();
+        static thread_local SPTR sptr;
+        static thread_local size_t target;
+        if( this->first_call() ) {
+            sptr = SPTR{ new test{ this->get_worker_id()*2+1 } };
+            target = contention? 0 : this->get_worker_id();
+        }
 
         SPTR exp;
         while( !this->atomic_sptrs_[target].asp_.compare_exchange_weak(
@@ -184,8 +413,12 @@ public:
         return SptrExperiment<ASPTR, contention>::experiment::run( &e_cas_strong_loop<SPTR, ASPTR, contention>::shoot );
     }
     void shoot() {
-        static thread_local SPTR sptr{ new test{ this->get_worker_id()*2+1 } };
-        static thread_local size_t target = contention? 0 :this->get_worker_id();
+        static thread_local SPTR sptr;
+        static thread_local size_t target;
+        if( this->first_call() ) {
+            sptr = SPTR{ new test{ this->get_worker_id()*2+1 } };
+            target = contention? 0 : this->get_worker_id();
+        }
 
         SPTR exp;
         while( !this->atomic_sptrs_[target].asp_.compare_exchange_strong(
@@ -206,8 +439,12 @@ public:
         return SptrExperiment<ASPTR, contention>::experiment::run( &e_cas_weak<SPTR, ASPTR, contention>::shoot );
     }
     void shoot() {
-        static thread_local SPTR sptr{ new test{ this->get_worker_id()*2+1 } };
-        static thread_local size_t target = 0;
+        static thread_local SPTR sptr;
+        static thread_local size_t target;
+        if( this->first_call() ) {
+            sptr = SPTR{ new test{ this->get_worker_id()*2+1 } };
+            target = 0;
+        }
         target = contention? ( target+1 ) % this->atomic_sptrs_.size() : this->get_worker_id();
 
         SPTR exp;
@@ -226,8 +463,12 @@ public:
         return SptrExperiment<ASPTR, contention>::experiment::run( &e_cas_strong<SPTR, ASPTR, contention>::shoot );
     }
     void shoot() {
-        static thread_local SPTR sptr{ new test{ this->get_worker_id()*2+1 } };
-        static thread_local size_t target = contention? 0 :this->get_worker_id();
+        static thread_local SPTR sptr;
+        static thread_local size_t target;
+        if( this->first_call() ) {
+            sptr = SPTR{ new test{ this->get_worker_id()*2+1 } };
+            target = contention? 0 : this->get_worker_id();
+        }
         target = contention? ( target+1 ) % this->atomic_sptrs_.size() : this->get_worker_id();
 
         SPTR exp;
@@ -235,6 +476,739 @@ public:
     }
 };
 
+/*
+ * Parses a mix like "load=95,store=4,cas=1" into mix_weights; operations not given get weight 0. The weights must be
+ * non-negative integers, and at least one must be positive.
+ */
+bool parse_mix( const std::string& spec ) {
+    std::fill( std::begin( mix_weights ), std::end( mix_weights ), 0u );
+    std::stringstream ss( spec );
+    std::string entry;
+    unsigned total = 0;
+    while( std::getline( ss, entry, ',' )) {
+        const auto eq = entry.find( '=' );
+        const auto it = std::find( std::begin( mixed_op_names ), std::end( mixed_op_names ), entry.substr( 0, eq ));
+        if( eq == std::string::npos || it == std::end( mixed_op_names ))
+            return false;
+        char* end = nullptr;
+        const auto weight = std::strtol( entry.c_str()+eq+1, &end, 10 );
+        if( end == entry.c_str()+eq+1 || *end != '\0' || weight < 0 )
+            return false;
+        mix_weights[it - std::begin( mixed_op_names )] = unsigned( weight );
+        total += mix_weights[it - std::begin( mixed_op_names )];
+    }
+    return total > 0;
+}
+
+/*
+ * Each call draws one of load, store, exchange and cas (a load and a compare_exchange_strong expecting the loaded
+ * value) according to mix_weights
+ * and applies it to a target drawn from the distribution given by -dist (with contention) or to the worker's own
+ * variable (without). Besides the total throughput, it reports the throughput of each operation within the mix.
+ */
+template<class SPTR, class ASPTR, bool contention = true>
+class e_mixed : public SptrExperiment<ASPTR, contention> {
+public:
+    e_mixed( size_t n_workers, size_t n_vars, auto run_time = 1.0s ) :
+            SptrExperiment<ASPTR, contention>( n_workers, n_vars, run_time ),
+            targets_( this->atomic_sptrs_.size(), dist_zipf_s ),
+            counts_( n_workers )
+    {
+        for( auto i = 0u; i < this->atomic_sptrs_.size(); ++i )
+            this->atomic_sptrs_[i].asp_.store( SPTR{ new test{ i*2 }} );
+
+        unsigned sum = 0;
+        for( auto op = 0u; op < n_mixed_ops; ++op )
+            thresholds_[op] = sum += mix_weights[op];
+    }
+    size_t run() {
+        return SptrExperiment<ASPTR, contention>::experiment::run( &e_mixed<SPTR, ASPTR, contention>::shoot );
+    }
+    void shoot() {
+        static thread_local jps::fast_rng rng;
+        static thread_local SPTR sptr;
+        if( this->first_call() ) {
+            rng = jps::fast_rng{ this->get_worker_id() };
+            sptr = SPTR{ new test{ this->get_worker_id()*2+1 } };
+        }
+        const auto target = contention? targets_( rng ) : this->get_worker_id();
+        auto& asp = this->atomic_sptrs_[target].asp_;
+
+        const auto r = unsigned( rng.below( thresholds_[n_mixed_ops-1] ));
+        auto op = 0u;
+        while( r >= thresholds_[op] )
+            ++op;
+        switch( op ) {
+            case mixed_load:
+                asp.load( std::memory_order_acquire );
+                break;
+            case mixed_store:
+                asp.store( sptr, std::memory_order_release );
+                break;
+            case mixed_exchange:
+                sptr = asp.exchange( std::move( sptr ), std::memory_order_acq_rel );
+                break;
+            default: {
+                // expect the current value, so that the cas publishes unless another worker got in between
+                auto exp = asp.load( std::memory_order_acquire );
+                asp.compare_exchange_strong( exp, sptr, std::memory_order_acq_rel );
+            }
+        }
+        ++counts_[this->get_worker_id()].n[op];
+    }
+
+    static std::vector<std::string> metric_names() {
+        std::vector<std::string> names;
+        for( auto op = 0u; op < n_mixed_ops; ++op )
+            if( mix_weights[op] )
+                names.push_back( std::string( "throughput_" ) + mixed_op_names[op] );
+        return names;
+    }
+    /*
+     * Splits the throughput of the trial by the observed share of each operation.
+     */
+    std::vector<double> metrics( double throughput ) const {
+        size_t per_op[n_mixed_ops] = {};
+        size_t total = 0;
+        for( auto& c: counts_ ) {
+            for( auto op = 0u; op < n_mixed_ops; ++op ) {
+                per_op[op] += c.n[op];
+                total += c.n[op];
+            }
+        }
+
+        std::vector<double> values;
+        for( auto op = 0u; op < n_mixed_ops; ++op )
+            if( mix_weights[op] )
+                values.push_back( total? throughput * double( per_op[op] ) / double( total ) : 0. );
+        return values;
+    }
+
+private:
+    struct alignas( 128 ) op_counts {
+        size_t n[n_mixed_ops] = {};
+    };
+
+    jps::target_distribution targets_;
+    unsigned thresholds_[n_mixed_ops];
+    std::vector<op_counts> counts_;     ///< per worker, including the warm-up
+};
+
+/*
+ * Scenario: a configuration read by many and replaced now and then. Every call loads a configuration and reads it;
+ * every reload_every-th call of the writer (worker 0 with contention, each worker on its own variable without)
+ * publishes a freshly allocated one instead.
+ */
+template<class SPTR, class ASPTR, bool contention = true>
+class e_config_reload : public SptrExperiment<ASPTR, contention> {
+public:
+    e_config_reload( size_t n_workers, size_t n_vars, auto run_time = 1.0s ) :
+            SptrExperiment<ASPTR, contention>( n_workers, n_vars, run_time )
+    {
+        for( auto i = 0u; i < this->atomic_sptrs_.size(); ++i )
+            this->atomic_sptrs_[i].asp_.store( SPTR{ new test{ i }} );
+    }
+    size_t run() {
+        return SptrExperiment<ASPTR, contention>::experiment::run( &e_config_reload<SPTR, ASPTR, contention>::shoot );
+    }
+    void shoot() {
+        static thread_local size_t target;
+        static thread_local size_t calls;
+        [[maybe_unused]] static thread_local volatile uint64_t sink;
+        if( this->first_call() )
+            target = calls = 0;
+        target = contention? ( target+1 ) % this->atomic_sptrs_.size() : this->get_worker_id();
+
+        if(( !contention || this->get_worker_id() == 0 ) && ++calls % reload_every == 0 ) {
+            this->atomic_sptrs_[target].asp_.store( SPTR{ new test{ calls }}, std::memory_order_release );
+            return;
+        }
+        const auto config = this->atomic_sptrs_[target].asp_.load( std::memory_order_acquire );
+        sink = config->u;
+    }
+};
+
+/*
+ * Scenario: producers hand freshly allocated objects over to consumers through exchange. Even workers produce
+ * (exchange in a new object), odd workers consume (exchange in null); a single worker alternates. Without
+ * contention, worker 2k and 2k+1 form a pair sharing variable k. Besides the
+ * throughput of the exchanges, it reports the throughput of actual hand-offs (objects taken by a consumer).
+ */
+template<class SPTR, class ASPTR, bool contention = true>
+class e_handoff : public SptrExperiment<ASPTR, contention> {
+public:
+    e_handoff( size_t n_workers, size_t n_vars, auto run_time = 1.0s ) :
+            SptrExperiment<ASPTR, contention>( n_workers, n_vars, run_time ),
+            counts_( n_workers )
+    {}
+    size_t run() {
+        return SptrExperiment<ASPTR, contention>::experiment::run( &e_handoff<SPTR, ASPTR, contention>::shoot );
+    }
+    void shoot() {
+        auto& counts = counts_[this->get_worker_id()];
+        const auto single = this->n_workers_ == 1;
+        const auto produce = single? counts.calls % 2 == 0 : this->get_worker_id() % 2 == 0;
+
+        // a single worker consumes from the variable it just produced to; without contention, consumer 2k+1 takes
+        // from the variable of producer 2k
+        const auto target = contention? ( single? counts.calls/2 : counts.calls ) % this->atomic_sptrs_.size()
+                                      : this->get_worker_id() / 2;
+        if( produce )
+            this->atomic_sptrs_[target].asp_.exchange( SPTR{ new test{ counts.calls }}, std::memory_order_acq_rel );
+        else if( this->atomic_sptrs_[target].asp_.exchange( SPTR{}, std::memory_order_acq_rel ))
+            ++counts.handoffs;
+        ++counts.calls;
+    }
+
+    static std::vector<std::string> metric_names() {
+        return { "throughput_handoff" };
+    }
+    std::vector<double> metrics( double throughput ) const {
+        size_t calls = 0, handoffs = 0;
+        for( auto& c: counts_ ) {
+            calls += c.calls;
+            handoffs += c.handoffs;
+        }
+        return { calls? throughput * double( handoffs ) / double( calls ) : 0. };
+    }
+
+private:
+    struct alignas( 128 ) handoff_counts {
+        size_t calls = 0;
+        size_t handoffs = 0;
+    };
+    std::vector<handoff_counts> counts_;     ///< per worker, including the warm-up
+};
+
+/*
+ * Ticks per ns measured once over 10 ms, for converting times into ticks before an experiment calibrated them.
+ */
+double estimated_ticks_per_ns() {
+    static const double estimate = [] {
+        const auto ticks1 = jps::ticks();
+        const auto time1 = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for( 10ms );
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - time1;
+        return double( jps::ticks() - ticks1 ) / elapsed.count();
+    }();
+    return estimate;
+}
+
+/*
+ * Publish-to-observe latency: writers store objects stamped with the time stamp counter, readers load in a loop
+ * and record the time from the stamp to the first load returning the object. With contention worker 0 writes to
+ * all variables round-robin and the others read them round-robin; without, worker 2k writes variable k and worker
+ * 2k+1 reads it. A single worker alternates. A writer publishes at most every publish_interval (calls in between
+ * return at once) to leave the readers time to observe each object. The initial objects count as seen. Besides the
+ * latencies (in ns, including the warm-up), it reports how many readers observed a published object on average
+ * (objects replaced before a reader loaded them are missed).
+ */
+template<class SPTR, class ASPTR, bool contention = true>
+class e_propagation : public SptrExperiment<ASPTR, contention> {
+public:
+    e_propagation( size_t n_workers, size_t n_vars, auto run_time = 1.0s ) :
+            SptrExperiment<ASPTR, contention>( n_workers, n_vars, run_time ),
+            workers_( n_workers ),
+            interval_ticks_( uint64_t( double( publish_interval.count() ) * estimated_ticks_per_ns() ))
+    {
+        // the initial objects are not published by a writer: seen by all readers, they record no latency
+        std::vector<uint64_t> initial;
+        for( auto i = 0u; i < this->atomic_sptrs_.size(); ++i ) {
+            initial.push_back( jps::ticks() );
+            this->atomic_sptrs_[i].asp_.store( SPTR{ new test{ initial.back() }} );
+        }
+        for( auto& w: workers_ )
+            w.last_seen = initial;
+    }
+    size_t run() {
+        return SptrExperiment<ASPTR, contention>::experiment::run( &e_propagation<SPTR, ASPTR, contention>::shoot );
+    }
+    void shoot() {
+        const auto id = this->get_worker_id();
+        auto& w = workers_[id];
+        const auto single = this->n_workers_ == 1;
+        const auto write = single? w.calls % 2 == 0 : contention? id == 0 : id % 2 == 0;
+        const auto target = contention? ( single? w.calls/2 : w.calls ) % this->atomic_sptrs_.size() : id / 2;
+        ++w.calls;
+        auto& asp = this->atomic_sptrs_[target].asp_;
+
+        if( write ) {
+            const auto now = jps::ticks();
+            if( now - w.last_publish < interval_ticks_ )
+                return;
+            w.last_publish = now;
+            // stamp after the allocation, so that its cost does not count as propagation latency
+            SPTR object{ new test{ 0 }};
+            object->u = jps::ticks();
+            asp.store( std::move( object ), std::memory_order_release );
+            ++w.published;
+            return;
+        }
+        const auto object = asp.load( std::memory_order_acquire );
+        const auto now = jps::ticks();
+        if( object->u != w.last_seen[target] ) {
+            w.last_seen[target] = object->u;
+            w.latencies.record( now > object->u? now - object->u : 0 );
+        }
+    }
+
+    static std::vector<std::string> metric_names() {
+        return { "observe_p50_ns", "observe_p99_ns", "observe_max_ns", "observers_per_publish" };
+    }
+    std::vector<double> metrics( double ) const {
+        jps::log_histogram all;
+        size_t published = 0;
+        for( auto& w: workers_ ) {
+            all.merge( w.latencies );
+            published += w.published;
+        }
+        const auto ns = [this]( uint64_t ticks ) { return double( ticks ) / this->ticks_per_ns(); };
+        return { ns( all.percentile( .5 )), ns( all.percentile( .99 )), ns( all.max() ),
+                 published? double( all.count() ) / double( published ) : 0. };
+    }
+
+private:
+    struct alignas( 128 ) worker_state {
+        size_t calls = 0;
+        size_t published = 0;
+        uint64_t last_publish = 0;
+        std::vector<uint64_t> last_seen;    ///< stamp of the object last loaded, per variable
+        jps::log_histogram latencies;
+    };
+    std::vector<worker_state> workers_;
+    const uint64_t interval_ticks_;
+};
+
+/*
+ * Rebinds an (atomic) shared pointer type to another element type, e.g. jps::atomic_shared_ptr<test> to
+ * jps::atomic_shared_ptr<U> or std::atomic<std::shared_ptr<test>> to std::atomic<std::shared_ptr<U>>.
+ */
+template<class P, class U> struct rebind_ptr;
+template<template<class> class P, class T, class U>
+struct rebind_ptr<P<T>, U> { using type = P<U>; };
+template<template<class> class A, template<class> class P, class T, class U>
+struct rebind_ptr<A<P<T>>, U> { using type = A<P<U>>; };
+
+/*
+ * Scenario: a singly linked list whose links are atomic shared pointers. Every call traverses a whole list of
+ * vars nodes (one list shared by all workers with contention, one list per worker without); every reload_every-th
+ * call of the writer replaces one node by a fresh copy instead.
+ */
+template<class SPTR, class ASPTR, bool contention = true>
+class e_list_traversal : public jps::experiment {
+    struct list_node;
+    using node_sptr = typename rebind_ptr<SPTR, list_node>::type;
+    using node_asptr = typename rebind_ptr<ASPTR, list_node>::type;
+    struct list_node {
+        explicit list_node( uint64_t u ) : u( u ) {}
+        uint64_t u;
+        node_asptr next;
+    };
+
+public:
+    e_list_traversal( size_t n_workers, size_t n_vars, auto run_time = 1.0s ) :
+            jps::experiment( n_workers, run_time, warmup_time ),
+            length_( n_vars ),
+            heads_( contention? 1:n_workers )
+    {
+        for( auto& h: heads_ ) {
+            for( auto i = 0u; i < length_; ++i ) {
+                node_sptr n{ new list_node{ length_-i }};
+                n->next.store( h.head_.load() );
+                h.head_.store( std::move( n ));
+            }
+        }
+    }
+    size_t run() {
+        return experiment::run( &e_list_traversal<SPTR, ASPTR, contention>::shoot );
+    }
+    void shoot() {
+        static thread_local size_t calls;
+        [[maybe_unused]] static thread_local volatile uint64_t sink;
+        if( first_call() )
+            calls = 0;
+        auto& head = heads_[contention? 0 : get_worker_id()].head_;
+
+        if(( !contention || get_worker_id() == 0 ) && ++calls % reload_every == 0 ) {
+            _replace( head, calls / reload_every % length_ );
+            return;
+        }
+        for( auto n = head.load( std::memory_order_acquire ); n; n = n->next.load( std::memory_order_acquire ))
+            sink = n->u;
+    }
+
+private:
+    /*
+     * Replaces the node at the given position by a copy; there is a single writer per list.
+     */
+    void _replace( node_asptr& head, size_t position ) {
+        node_asptr* link = &head;
+        for( auto i = 0u; i < position; ++i ) {
+            const auto n = link->load( std::memory_order_acquire );
+            link = &n->next;
+        }
+        const auto old = link->load( std::memory_order_acquire );
+        node_sptr copy{ new list_node{ old->u }};
+        copy->next.store( old->next.load( std::memory_order_acquire ));
+        link->store( std::move( copy ), std::memory_order_release );
+    }
+
+    struct alignas( 128 ) list_head {
+        node_asptr head_;
+    };
+    size_t length_;
+    std::vector<list_head> heads_;
+};
+
+/*
+ * Scenario: counters held in immutable objects and incremented by a CAS loop that publishes a fresh copy
+ * (read-copy-update).
+ */
+template<class SPTR, class ASPTR, bool contention = true>
+class e_counter : public SptrExperiment<ASPTR, contention> {
+public:
+    e_counter( size_t n_workers, size_t n_vars, auto run_time = 1.0s ) :
+            SptrExperiment<ASPTR, contention>( n_workers, n_vars, run_time )
+    {
+        for( auto i = 0u; i < this->atomic_sptrs_.size(); ++i )
+            this->atomic_sptrs_[i].asp_.store( SPTR{ new test{ 0 }} );
+    }
+    size_t run() {
+        return SptrExperiment<ASPTR, contention>::experiment::run( &e_counter<SPTR, ASPTR, contention>::shoot );
+    }
+    void shoot() {
+        static thread_local size_t target;
+        if( this->first_call() )
+            target = 0;
+        target = contention? ( target+1 ) % this->atomic_sptrs_.size() : this->get_worker_id();
+        auto& asp = this->atomic_sptrs_[target].asp_;
+
+        auto cur = asp.load( std::memory_order_acquire );
+        SPTR next{ new test{ cur->u + 1 }};
+        while( !asp.compare_exchange_weak( cur, next, std::memory_order_acq_rel, std::memory_order_acquire ))
+            next->u = cur->u + 1;      // not published yet
+    }
+};
+
+template<class SPTR> struct weak_of;
+template<class T> struct weak_of<jps::shared_ptr<T>> { using type = jps::weak_ptr<T>; };
+template<class T> struct weak_of<std::shared_ptr<T>> { using type = std::weak_ptr<T>; };
+template<class T> struct weak_of<boost::shared_ptr<T>> { using type = boost::weak_ptr<T>; };
+
+template<class SPTR> struct sptr_factory;
+template<class T> struct sptr_factory<jps::shared_ptr<T>> {
+    template<class... Args> static auto make( Args&&... args ) { return jps::make_shared<T>( std::forward<Args>( args )... ); }
+};
+template<class T> struct sptr_factory<std::shared_ptr<T>> {
+    template<class... Args> static auto make( Args&&... args ) { return std::make_shared<T>( std::forward<Args>( args )... ); }
+};
+template<class T> struct sptr_factory<boost::shared_ptr<T>> {
+    template<class... Args> static auto make( Args&&... args ) { return boost::make_shared<T>( std::forward<Args>( args )... ); }
+};
+
+/*
+ * Every call publishes a fresh object of Size bytes created by the library's make_shared (store to the next target
+ * with contention, to the worker's own variable without), so that the replaced object is destroyed, running a
+ * destructor of churn_dtor_work spin iterations. The resident set size is sampled every 10 ms during each trial,
+ * on a cpu that runs no worker if there is one; its peak is reported together with the growth of the bytes in use
+ * by the allocator over the trial (read at its start and end only, as that locks the malloc arenas), and all samples
+ * are appended to -memory_trace.
+ */
+template<size_t Size, class SPTR, class ASPTR, bool contention = true>
+class e_churn : public jps::experiment {
+    struct churn_object {
+        explicit churn_object( uint64_t u ) : u( u )
+        {
+            std::memset( payload, int( u ), sizeof( payload ));
+        }
+        ~churn_object()
+        {
+            for( auto i = 0u; i < churn_dtor_work; ++i )
+                std::atomic_signal_fence( std::memory_order_seq_cst );
+        }
+        uint64_t u;
+        char payload[Size - sizeof( uint64_t )];
+    };
+    using object_sptr = typename rebind_ptr<SPTR, churn_object>::type;
+    using object_asptr = typename rebind_ptr<ASPTR, churn_object>::type;
+
+public:
+    e_churn( size_t n_workers, size_t n_vars, auto run_time = 1.0s ) :
+            jps::experiment( n_workers, run_time, warmup_time ),
+            slots_( contention? n_vars:n_workers )
+    {
+        for( auto i = 0u; i < slots_.size(); ++i )
+            slots_[i].asp_.store( sptr_factory<object_sptr>::make( i ));
+    }
+    size_t run() {
+        jps::memory_sampler sampler( 10ms, sampler_cpu() );
+        const auto n_ops = experiment::run( &e_churn<Size, SPTR, ASPTR, contention>::shoot );
+        const auto& samples = sampler.stop();
+
+        rss_peak_ = 0.;
+        heap_growth_ = double( samples.back().heap_in_use.value_or( 0 ))
+                     - double( samples.front().heap_in_use.value_or( 0 ));
+        for( auto& m: samples ) {
+            rss_peak_ = std::max( rss_peak_, double( m.rss ));
+            if( memory_trace.is_open() ) {
+                memory_trace << current_operation << "\t" << current_library << "\t" << contention << "\t"
+                             << slots_.size() << "\t" << n_workers_ << "\t" << m.ms << "\t" << m.rss << "\t";
+                if( m.heap_in_use )
+                    memory_trace << *m.heap_in_use;
+                memory_trace << "\n";
+            }
+        }
+        return n_ops;
+    }
+    void shoot() {
+        static thread_local size_t target;
+        if( first_call() )
+            target = 0;
+        target = contention? ( target+1 ) % slots_.size() : get_worker_id();
+        slots_[target].asp_.store( sptr_factory<object_sptr>::make( target ), std::memory_order_release );
+    }
+
+    static std::vector<std::string> metric_names() {
+        return { "rss_peak_mb", "heap_growth_mb" };
+    }
+    std::vector<double> metrics( double ) const {
+        return { rss_peak_ / 1048576., heap_growth_ / 1048576. };
+    }
+
+private:
+    /*
+     * A cpu that runs no worker: past the ones the workers are pinned to, or past the first n_workers online cpus
+     * if they are not pinned; -1 if every cpu runs a worker.
+     */
+    int sampler_cpu() const {
+        std::vector<int> busy;
+        if( pin_cpus.empty() ) {
+            if( n_workers_ >= std::thread::hardware_concurrency() )
+                return -1;
+        } else {
+            busy.assign( pin_cpus.begin(), pin_cpus.begin() + std::min( n_workers_, pin_cpus.size() ));
+        }
+        return jps::free_cpu( busy );
+    }
+
+    struct alignas( 128 ) object_slot {
+        object_asptr asp_;
+    };
+    std::vector<object_slot> slots_;
+    double rss_peak_ = 0.;
+    double heap_growth_ = 0.;
+};
+
+template<size_t Size>
+struct churn_experiment {
+    template<class SPTR, class ASPTR, bool contention>
+    using type = e_churn<Size, SPTR, ASPTR, contention>;
+};
+
+/*
+ * Reclamation: the writer (worker 0 with contention, each worker on its own variable without) replaces the object
+ * of the next target on every call, by store (Exchange = false) or exchange; the other workers load and read the
+ * objects meanwhile. Every displaced object is stamped with the time its replacement started and records, when its
+ * destructor runs, the time since then, i.e. how long the displaced value outlived the replacement (in the
+ * writer's call for the split reference counts, later when a reader held the last reference or the scheme defers
+ * the reclamation). For store, the writer stamps the object it loaded right before, which is the one displaced as
+ * it is the only writer of the variable. Besides the latencies (including the warm-up), it reports the peak number
+ * and bytes (of the objects, without control blocks) of displaced objects not yet destroyed.
+ */
+template<bool Exchange, class SPTR, class ASPTR, bool contention = true>
+class e_reclaim : public jps::experiment {
+    struct reclaim_object {
+        explicit reclaim_object( uint64_t u ) : u( u ), generation( generation_ )
+        {}
+        ~reclaim_object()
+        {
+            const auto stamp = displaced_at.load( std::memory_order_relaxed );
+            if( stamp && generation == generation_.load( std::memory_order_relaxed )) {
+                // the stamp may come from another core whose time stamp counter is ahead
+                const auto now = jps::ticks();
+                _reclaimed( now > stamp? now - stamp : 0 );
+            }
+        }
+        uint64_t u;
+        uint64_t generation;
+        std::atomic<uint64_t> displaced_at{ 0 };
+        char payload[64 - 3*sizeof( uint64_t )];
+    };
+    using object_sptr = typename rebind_ptr<SPTR, reclaim_object>::type;
+    using object_asptr = typename rebind_ptr<ASPTR, reclaim_object>::type;
+
+public:
+    e_reclaim( size_t n_workers, size_t n_vars, auto run_time = 1.0s ) :
+            jps::experiment( n_workers, run_time, warmup_time ),
+            slots_( contention? n_vars:n_workers )
+    {
+        // objects displaced by an earlier experiment (e.g. still retired by a deferring scheme) are not counted
+        latencies_.assign( n_workers, {} );
+        unreclaimed_.store( 0, std::memory_order_relaxed );
+        unreclaimed_peak_.store( 0, std::memory_order_relaxed );
+        generation_.fetch_add( 1, std::memory_order_relaxed );
+        for( auto i = 0u; i < slots_.size(); ++i )
+            slots_[i].asp_.store( object_sptr{ new reclaim_object{ i }} );
+    }
+    size_t run() {
+        return experiment::run( &e_reclaim<Exchange, SPTR, ASPTR, contention>::shoot );
+    }
+    void shoot() {
+        static thread_local size_t target;
+        [[maybe_unused]] static thread_local volatile uint64_t sink;
+        if( first_call() )
+            target = 0;
+        target = contention? ( target+1 ) % slots_.size() : get_worker_id();
+        auto& asp = slots_[target].asp_;
+
+        if( contention && get_worker_id() != 0 ) {
+            const auto object = asp.load( std::memory_order_acquire );
+            sink = object->u;
+            return;
+        }
+
+        object_sptr fresh{ new reclaim_object{ target }};
+        if constexpr( Exchange ) {
+            const auto start = jps::ticks();
+            const auto displaced = asp.exchange( std::move( fresh ), std::memory_order_acq_rel );
+            _displaced( *displaced, start );
+        }
+        else {
+            auto* displaced = asp.load( std::memory_order_acquire ).get();    // kept alive by the variable
+            const auto start = jps::ticks();
+            _displaced( *displaced, start );
+            asp.store( std::move( fresh ), std::memory_order_release );
+        }
+    }
+
+    static std::vector<std::string> metric_names() {
+        return { "reclaim_p50_us", "reclaim_p99_us", "reclaim_max_us", "unreclaimed_peak", "unreclaimed_peak_kb" };
+    }
+    std::vector<double> metrics( double ) const {
+        jps::log_histogram all;
+        for( auto& l: latencies_ )
+            all.merge( l.histogram );
+        const auto us = [this]( uint64_t ticks ) { return double( ticks ) / ticks_per_ns() / 1000.; };
+        const auto peak = double( unreclaimed_peak_.load( std::memory_order_acquire ));
+        return { us( all.percentile( .5 )), us( all.percentile( .99 )), us( all.max() ),
+                 peak, peak * double( sizeof( reclaim_object )) / 1024. };
+    }
+
+private:
+    /*
+     * Stamps the displaced object and counts it as unreclaimed until its destructor runs.
+     */
+    static void _displaced( reclaim_object& displaced, uint64_t start ) {
+        const auto n = unreclaimed_.fetch_add( 1, std::memory_order_relaxed ) + 1;
+        auto peak = unreclaimed_peak_.load( std::memory_order_relaxed );
+        while( n > peak && !unreclaimed_peak_.compare_exchange_weak( peak, n, std::memory_order_relaxed ))
+            ;
+        displaced.displaced_at.store( start, std::memory_order_relaxed );
+    }
+    static void _reclaimed( uint64_t latency ) {
+        unreclaimed_.fetch_sub( 1, std::memory_order_relaxed );
+        latencies_[get_worker_id() % latencies_.size()].histogram.record( latency );
+    }
+
+    struct alignas( 128 ) object_slot {
+        object_asptr asp_;
+    };
+    struct alignas( 128 ) worker_latencies {
+        jps::log_histogram histogram;
+    };
+    std::vector<object_slot> slots_;
+
+    // shared with the destructors of the objects, which may run after the experiment is gone (see generation_)
+    inline static std::atomic<uint64_t> generation_{ 0 };
+    inline static std::atomic<int64_t> unreclaimed_{ 0 };
+    inline static std::atomic<int64_t> unreclaimed_peak_{ 0 };
+    inline static std::vector<worker_latencies> latencies_;
+};
+
+template<bool Exchange>
+struct reclaim_experiment {
+    template<class SPTR, class ASPTR, bool contention>
+    using type = e_reclaim<Exchange, SPTR, ASPTR, contention>;
+};
+
+/*
+ * Operations on the shared and weak pointers themselves (no atomic shared pointer involved):
+ * - sp_copy: copy a shared pointer and destroy the copy,
+ * - sp_move: move a shared pointer out and back,
+ * - sp_deref: read the object through operator->,
+ * - sp_destroy: create the sole owner of a new object and destroy it (i.e. including the allocation),
+ * - wp_construct: construct a weak pointer from a shared pointer and destroy it,
+ * - wp_lock: lock a weak pointer and destroy the result,
+ * - wp_expired: check whether a weak pointer has expired.
+ * With contention, worker i works on shared pointer i % vars, i.e. with vars = 1 all workers copy, lock, ... the
+ * same pointer; without, each worker has its own.
+ */
+template<sptr_op op, class SPTR, class ASPTR, bool contention = true>
+class e_sptr : public jps::experiment {
+    using WPTR = typename weak_of<SPTR>::type;
+
+public:
+    e_sptr( size_t n_workers, size_t n_vars, auto run_time = 1.0s ) :
+            jps::experiment( n_workers, run_time, warmup_time ),
+            shared_( contention? n_vars:n_workers ),
+            locals_( n_workers )
+    {
+        for( auto i = 0u; i < shared_.size(); ++i )
+            shared_[i].sp_ = SPTR{ new test{ i }};
+        for( auto w = 0u; w < n_workers; ++w ) {
+            locals_[w].sp_ = shared_[w % shared_.size()].sp_;
+            locals_[w].wp_ = shared_[w % shared_.size()].sp_;
+        }
+    }
+    size_t run() {
+        return experiment::run( &e_sptr<op, SPTR, ASPTR, contention>::shoot );
+    }
+    void shoot() {
+        [[maybe_unused]] static thread_local volatile uint64_t sink;
+        const auto id = get_worker_id();
+        const auto& shared = shared_[id % shared_.size()].sp_;
+        auto& local = locals_[id];
+
+        if constexpr( op == sp_copy ) {
+            SPTR copy{ shared };
+        }
+        else if constexpr( op == sp_move ) {
+            SPTR moved{ std::move( local.sp_ )};
+            local.sp_ = std::move( moved );
+        }
+        else if constexpr( op == sp_deref )
+            sink = shared->u;
+        else if constexpr( op == sp_destroy ) {
+            SPTR p{ new test{ id }};
+        }
+        else if constexpr( op == wp_construct ) {
+            WPTR w{ shared };
+        }
+        else if constexpr( op == wp_lock ) {
+            const auto p = local.wp_.lock();
+        }
+        else
+            sink = local.wp_.expired();
+    }
+
+private:
+    struct alignas( 128 ) shared_ptrs {
+        SPTR sp_;
+    };
+    struct alignas( 128 ) local_ptrs {
+        SPTR sp_;
+        WPTR wp_;
+    };
+    std::vector<shared_ptrs> shared_;
+    std::vector<local_ptrs> locals_;
+};
+
+template<sptr_op op>
+struct sptr_experiment {
+    template<class SPTR, class ASPTR, bool contention>
+    using type = e_sptr<op, SPTR, ASPTR, contention>;
+};
+
 double measure( size_t v, size_t t, size_t n, void (*test)( size_t, size_t, size_t ) ) {
     auto t1 = std::chrono::high_resolution_clock::now();
     test( v, t, n );
@@ -248,167 +1222,819 @@ double measure( size_t v, size_t t, size_t n, void (*test)( size_t, size_t, size
     return t * n / mus_double.count();
 }
 
+/*
+ * The result of all trials of one (vars, threads) point.
+ */
+struct point_result {
+    jps::sample_stats throughput;       ///< ops/us per trial
+    size_t n_ops = 0;
+    jps::log_histogram latencies;
+    double ticks_per_ns = 0.;
+    std::vector<std::optional<double>> perf_totals;
+    double warmup_ms = 0.;                      ///< mean over the trials
+    jps::fairness_stats fairness;               ///< mean over the trials
+    double max_stall_ns = 0.;                   ///< of any worker in any trial
+    std::vector<double> worker_max_stalls_ns;   ///< per worker, in any trial
+    std::vector<double> experiment_metrics;     ///< mean over the trials of the metrics reported by T::metrics()
+};
+
+/*
+ * Runs trials of trial_time until the 95% confidence interval of the mean throughput is narrower than
+ * target_rel_ci (relative to the mean), but at least at_least_trials trials and at most max_time_per_point in total.
+ * The time per point is wall-clock time including warm-up, setup and teardown; another trial only starts if it would
+ * end within max_time_per_point taking as long as the longest trial so far.
+ */
 template<class T>
-void test_lib( const std::string& lib, size_t repeat ) {
+point_result measure_point( size_t v, size_t t, size_t at_least_trials ) {
+    point_result result;
+    result.perf_totals.assign( perf_events.size(), 0. );
+    result.fairness = { 0., 0., 0. };
+    std::vector<double> throughputs;
+    const auto point_start = std::chrono::steady_clock::now();
+    auto trial_start = point_start;
+    std::chrono::steady_clock::duration longest_trial{ 0 };
+    std::chrono::steady_clock::duration elapsed{ 0 };
+
+    do {
+        T test( t, v, trial_time );
+        test.use_pool( *pool );
+        test.sample_latency( latency_sample_every );
+        test.count_perf_events( perf_events );
+        test.detect_steady_state( steady_tolerance, 5, sample_period, max_warmup_time );
+        test.track_stalls( measure_stalls );
+        if( timeseries_out.is_open() )
+            test.record_progress( sample_period );
+        const auto n_ops = test.run();
+
+        for( auto& sample: test.progress_samples() ) {
+            timeseries_out << current_operation << "\t" << current_library << "\t" << current_contention << "\t"
+                           << v << "\t" << t << "\t" << throughputs.size() << "\t" << sample.ms << "\t"
+                           << sample.measuring;
+            for( auto hits: sample.hits )
+                timeseries_out << "\t" << hits;
+            timeseries_out << "\n";
+        }
+        result.warmup_ms += test.warmup_time_used().count();
+
+        const std::chrono::duration<double, std::micro> trial_us = trial_time;
+        throughputs.push_back( double( n_ops ) / trial_us.count() );
+        result.n_ops += n_ops;
+        result.latencies.merge( test.latencies() );
+        result.ticks_per_ns += test.ticks_per_ns();
+        for( auto e = 0u; e < perf_events.size(); ++e ) {
+            if( result.perf_totals[e] && test.perf_totals()[e] )
+                *result.perf_totals[e] += *test.perf_totals()[e];
+            else
+                result.perf_totals[e].reset();
+        }
+
+        const auto fairness = jps::fairness( test.worker_hits() );
+        result.fairness.min_max_ratio += fairness.min_max_ratio;
+        result.fairness.cv += fairness.cv;
+        result.fairness.jain += fairness.jain;
+        const auto stalls = test.worker_max_stalls_ns();
+        result.worker_max_stalls_ns.resize( stalls.size(), 0. );
+        for( auto w = 0u; w < stalls.size(); ++w ) {
+            result.worker_max_stalls_ns[w] = std::max( result.worker_max_stalls_ns[w], stalls[w] );
+            result.max_stall_ns = std::max( result.max_stall_ns, stalls[w] );
+        }
+
+        if constexpr( requires { T::metric_names(); } ) {
+            const auto values = test.metrics( throughputs.back() );
+            result.experiment_metrics.resize( values.size() );
+            for( auto i = 0u; i < values.size(); ++i )
+                result.experiment_metrics[i] += values[i];
+        }
+
+        result.throughput = jps::summarize( throughputs );
+
+        // the test is destroyed after this; its teardown counts towards the next trial
+        const auto now = std::chrono::steady_clock::now();
+        longest_trial = std::max( longest_trial, now - trial_start );
+        trial_start = now;
+        elapsed = now - point_start;
+    } while( throughputs.size() < at_least_trials
+             || ( result.throughput.relative_ci95() > target_rel_ci && elapsed + longest_trial <= max_time_per_point ));
+
+    result.ticks_per_ns /= double( throughputs.size() );
+    result.warmup_ms /= double( throughputs.size() );
+    result.fairness.min_max_ratio /= double( throughputs.size() );
+    result.fairness.cv /= double( throughputs.size() );
+    result.fairness.jain /= double( throughputs.size() );
+    for( auto& m: result.experiment_metrics )
+        m /= double( throughputs.size() );
+    return result;
+}
+
+/*
+ * Names of the metrics reported in addition to the throughput, in the order of point_metrics(): the latency
+ * percentiles, the hardware events per operation, the fairness among the workers and the metrics specific to the
+ * experiment T (if it defines metric_names() and metrics( throughput )).
+ */
+template<class T>
+std::vector<std::string> metric_names() {
+    std::vector<std::string> names;
+    if( latency_sample_every ) {
+        for( auto name: { "p50_ns", "p90_ns", "p99_ns", "p99.9_ns", "max_ns" } )
+            names.emplace_back( name );
+    }
+    for( auto& e: perf_events )
+        names.push_back( e.name + "_per_op" );
+    for( auto name: { "warmup_ms", "fair_min_max", "fair_cv", "fair_jain" } )
+        names.emplace_back( name );
+    if( measure_stalls )
+        names.emplace_back( "stall_max_us" );
+    if constexpr( requires { T::metric_names(); } ) {
+        const auto specific = T::metric_names();
+        names.insert( names.end(), specific.begin(), specific.end() );
+    }
+    return names;
+}
+
+template<class T>
+std::vector<std::pair<std::string, std::optional<double>>> point_metrics( const point_result& r ) {
+    std::vector<std::optional<double>> values;
+    if( latency_sample_every ) {
+        for( auto p: { .5, .9, .99, .999 } )
+            values.emplace_back( double( r.latencies.percentile( p )) / r.ticks_per_ns );
+        values.emplace_back( double( r.latencies.max() ) / r.ticks_per_ns );
+    }
+    for( auto& total: r.perf_totals ) {
+        if( total )
+            values.emplace_back( *total / double( r.n_ops ));
+        else
+            values.emplace_back();
+    }
+    values.emplace_back( r.warmup_ms );
+    values.emplace_back( r.fairness.min_max_ratio );
+    values.emplace_back( r.fairness.cv );
+    values.emplace_back( r.fairness.jain );
+    if( measure_stalls )
+        values.emplace_back( r.max_stall_ns / 1000. );
+    for( auto m: r.experiment_metrics )
+        values.emplace_back( m );
+
+    std::vector<std::pair<std::string, std::optional<double>>> metrics;
+    const auto names = metric_names<T>();
+    for( auto i = 0u; i < names.size(); ++i )
+        metrics.emplace_back( names[i], values[i] );
+    return metrics;
+}
+
+template<class T>
+void test_lib( const std::string& lib, size_t at_least_trials ) {
+    current_library = lib;
     std::cout << "=== library: " << lib << "\n"
-              << "vars\tthreads\tthroughput(ops/us)\n";
-    for( auto v = min_vars; v <= max_vars; v += 1 ) {
-        for( auto t = min_workers; t <= max_workers; ++t ) {
-            size_t n_ops = 0;
-            for( auto r = 0u; r < repeat; ++r ) {
-                T test( t, v, 2000ms );
-                n_ops += test.run();
+              << "vars\tthreads\tthroughput(ops/us)\tmedian(ops/us)\tci95(ops/us)\ttrials";
+    for( auto& name: metric_names<T>() )
+        std::cout << "\t" << name;
+    std::cout << "\n";
+    for( auto v: vars_grid ) {
+        for( auto t: workers_grid ) {
+            const auto key = current_operation + "/" + lib + "/" + ( current_contention? "contention" : "no_contention" )
+                             + "/" + std::to_string( v ) + "/" + std::to_string( t );
+            if( const auto row = checkpoint.find( key )) {
+                std::cout << *row << std::endl;
+                continue;
             }
-            // ops/100ms = ops/repeat  ==>  ops/s = 10*ops/repeat  ==>  ops/us = 10*ops/repeat/1'000'000 = ops/repeat/100'000
-            std::cout << v << "\t" << t << "\t" << double( n_ops ) / ( repeat * 2'000'000. ) << std::endl;
+
+            const auto r = measure_point<T>( v, t, at_least_trials );
+            jps::point_record record{ lib, current_operation, current_contention, v, t,
+                                      r.throughput, point_metrics<T>( r ) };
+
+            std::ostringstream row;
+            row << v << "\t" << t << "\t" << r.throughput.mean << "\t" << r.throughput.median
+                << "\t" << r.throughput.ci95 << "\t" << r.throughput.n;
+            for( auto& [name, value]: record.metrics ) {
+                if( value )
+                    row << "\t" << *value;
+                else
+                    row << "\tn/a";
+            }
+            checkpoint.record( key, row.str() );
+            std::cout << row.str() << std::endl;
+
+            // the longest stall of each worker, in the records only since the number of workers varies per row
+            for( auto w = 0u; measure_stalls && w < r.worker_max_stalls_ns.size(); ++w )
+                record.metrics.emplace_back( "stall_max_us_worker" + std::to_string( w ),
+                                             r.worker_max_stalls_ns[w] / 1000. );
+            if( json_out.is_open() )
+                jps::write_json( json_out, metadata, record );
+            if( csv_out.is_open() )
+                jps::write_csv( csv_out, metadata, record );
         }
     }
     std::cout << std::endl;
 }
 
+void begin_contention( bool contention ) {
+    current_contention = contention;
+    std::cout << "=== contention: " << ( contention? "true" : "false" ) << "\n";
+}
+
+/*
+ * Runs the experiment T with the given library with and/or without contention.
+ */
+template<template<class, class, bool> class T, class SPTR, class ASPTR>
+void test_variants( const std::string& lib, size_t at_least_trials ) {
+    const auto print_lock_free = [] {
+        if constexpr( requires { ASPTR::is_always_lock_free; } )
+            std::cout << "=== lock_free: " << ASPTR::is_always_lock_free << "\n";
+        if( sweeping_stride )
+            std::cout << "=== stride: " << effective_stride<ASPTR>( slot_stride ) << "\n";
+    };
+    if( measure_with_contention ) {
+        begin_contention( true );
+        print_lock_free();
+        test_lib<T<SPTR, ASPTR, true>>( lib, at_least_trials );
+    }
+    if( measure_without_contention ) {
+        begin_contention( false );
+        print_lock_free();
+        test_lib<T<SPTR, ASPTR, false>>( lib, at_least_trials );
+    }
+}
+
 template<template<class, class, bool> class T>
-void test_op( size_t repeat ) {
+void test_op( size_t at_least_trials ) {
 #ifdef MEASURE_JPS
-    if( measure_aios ) {
-        if( measure_with_contention ) {
-            std::cout << "=== contention: true\n";
-            std::cout << "=== lock_free: " << jps::atomic_shared_ptr<test>::is_always_lock_free << "\n";
-            test_lib<T<jps::shared_ptr<test>, jps::atomic_shared_ptr<test>, true>>(
-                    "jps", repeat );
-        }
-        if( measure_without_contention ) {
-            std::cout << "=== contention: false\n";
-            std::cout << "=== lock_free: " << jps::atomic_shared_ptr<test>::is_always_lock_free << "\n";
-            test_lib<T<jps::shared_ptr<test>, jps::atomic_shared_ptr<test>, false>>(
-                    "jps", repeat );
-        }
-    }
+    if( measure_aios )
+        test_variants<T, jps::shared_ptr<test>, jps::atomic_shared_ptr<test>>( "jps", at_least_trials );
 #endif
 
 #ifdef MEASURE_FOLLY
-    if( measure_folly ) {
-        if( measure_with_contention ) {
-            std::cout << "=== contention: true\n";
-            //std::cout << "=== jps: " << folly::atomic_shared_ptr<test>::is_always_lock_free << "\n";
-            test_lib<T<std::shared_ptr<test>, folly::atomic_shared_ptr<test>, true>>(
-                    "folly", repeat );
-        }
-        if( measure_without_contention ) {
-            std::cout << "=== contention: false\n";
-            //std::cout << "=== jps: " << folly::atomic_shared_ptr<test>::is_always_lock_free << "\n";
-            test_lib<T<std::shared_ptr<test>, folly::atomic_shared_ptr<test>, false>>(
-                    "folly", repeat );
-        }
-    }
+    if( measure_folly )
+        test_variants<T, std::shared_ptr<test>, folly::atomic_shared_ptr<test>>( "folly", at_least_trials );
 #endif
 
 #ifdef MEASURE_JSS
-    if( measure_jss ) {
-        if( measure_with_contention ) {
-            std::cout << "=== contention: true\n";
-            //std::cout << "=== jps: " << jss::atomic_shared_ptr<test>::is_always_lock_free << "\n";
-            test_lib<T<jss::shared_ptr<test>, jss::atomic_shared_ptr<test>, true>>(
-                    "jss", repeat );
-        }
-        if( measure_without_contention ) {
-            std::cout << "=== contention: false\n";
-            //std::cout << "=== jps: " << jss::atomic_shared_ptr<test>::is_always_lock_free << "\n";
-            test_lib<T<jss::shared_ptr<test>, jss::atomic_shared_ptr<test>, false>>(
-                    "jss", repeat );
-        }
-    }
+    if( measure_jss )
+        test_variants<T, jss::shared_ptr<test>, jss::atomic_shared_ptr<test>>( "jss", at_least_trials );
 #endif
 
 #ifdef MEASURE_STD
-    if( measure_std ) {
-        if( measure_with_contention ) {
-            std::cout << "=== contention: true\n";
-            std::cout << "=== lock_free: " << std::atomic<std::shared_ptr<test>>::is_always_lock_free << "\n";
-            test_lib<T<std::shared_ptr<test>, std::atomic<std::shared_ptr<test>>, true>>(
-                    "std", repeat );
-        }
-        if( measure_without_contention ) {
-            std::cout << "=== contention: false\n";
-            std::cout << "=== lock_free: " << std::atomic<std::shared_ptr<test>>::is_always_lock_free << "\n";
-            test_lib<T<std::shared_ptr<test>, std::atomic<std::shared_ptr<test>>, false>>(
-                    "std", repeat );
-        }
-    }
+    if( measure_std )
+        test_variants<T, std::shared_ptr<test>, std::atomic<std::shared_ptr<test>>>( "std", at_least_trials );
 #endif
 
 #ifdef MEASURE_VTYULB
-    if( measure_vtyulb ) {
-        if( measure_with_contention ) {
-            std::cout << "=== contention: true\n";
-            test_lib<T<LFStructs::SharedPtr<test>, LFStructs::AtomicSharedPtr<test>, true>>(
-                    "vtyulb", repeat );
-        }
-        if( measure_without_contention ) {
-            std::cout << "=== contention: false\n";
-            test_lib<T<LFStructs::SharedPtr<test>, LFStructs::AtomicSharedPtr<test>, false>>(
-                    "vtyulb", repeat );
+    if( measure_vtyulb )
+        test_variants<T, LFStructs::SharedPtr<test>, LFStructs::AtomicSharedPtr<test>>( "vtyulb", at_least_trials );
+#endif
+
+#ifdef MEASURE_BOOST
+    if( measure_boost )
+        test_variants<T, boost::shared_ptr<test>, boost::atomic_shared_ptr<test>>( "boost", at_least_trials );
+#endif
+
+#ifdef MEASURE_BASELINES
+    if( measure_mutex )
+        test_variants<T, std::shared_ptr<test>, jps::baseline::mutex_atomic_shared_ptr<test>>(
+                "mutex", at_least_trials );
+    if( measure_striped )
+        test_variants<T, std::shared_ptr<test>, jps::baseline::striped_atomic_shared_ptr<test>>(
+                "striped", at_least_trials );
+    if( measure_hazard )
+        test_variants<T, std::shared_ptr<test>, jps::baseline::hazard_atomic_shared_ptr<test>>(
+                "hazard", at_least_trials );
+#endif
+}
+
+/*
+ * Runs the experiment T with the libraries that bring their own shared and weak pointers.
+ */
+template<template<class, class, bool> class T>
+void test_sptr_libs( size_t at_least_trials ) {
+#ifdef MEASURE_JPS
+    if( measure_aios )
+        test_variants<T, jps::shared_ptr<test>, jps::atomic_shared_ptr<test>>( "jps", at_least_trials );
+#endif
+
+#ifdef MEASURE_STD
+    if( measure_std )
+        test_variants<T, std::shared_ptr<test>, std::atomic<std::shared_ptr<test>>>( "std", at_least_trials );
+#endif
+
+#ifdef MEASURE_BOOST
+    if( measure_boost )
+        test_variants<T, boost::shared_ptr<test>, boost::atomic_shared_ptr<test>>( "boost", at_least_trials );
+#endif
+}
+
+void begin_operation( const std::string& op ) {
+    current_operation = sweeping_stride? op + "[stride=" + std::to_string( slot_stride ) + "]" : op;
+    std::cout << "=== operation: " << current_operation << "\n";
+}
+
+/*
+ * Measures the cost of the harness itself per operation by running an empty test function.
+ */
+void report_harness_overhead()
+{
+    const auto run_time = 200ms;
+    jps::experiment e( 1, run_time, warmup_time );
+    e.use_pool( *pool );
+    const auto n_ops = e.run( []{ std::atomic_signal_fence( std::memory_order_seq_cst ); } );
+
+    const std::chrono::duration<double, std::nano> ns = run_time;
+    std::cout << "=== harness_overhead: " << ns.count() / double( n_ops ) << " ns/op\n";
+}
+
+/*
+ * Prints the header of the rows of a library for records with the given metrics.
+ */
+void begin_records( const std::string& lib, std::initializer_list<const char*> metric_names ) {
+    current_library = lib;
+    std::cout << "=== library: " << lib << "\n"
+              << "vars\tthreads\tthroughput(ops/us)\tmedian(ops/us)\tci95(ops/us)\ttrials";
+    for( auto name: metric_names )
+        std::cout << "\t" << name;
+    std::cout << "\n";
+}
+
+/*
+ * Prints the row of a record and appends it to the machine-readable outputs.
+ */
+void report_record( const jps::point_record& record ) {
+    std::cout << record.vars << "\t" << record.threads << "\t" << record.throughput.mean << "\t"
+              << record.throughput.median << "\t" << record.throughput.ci95 << "\t" << record.throughput.n;
+    for( auto& [name, value]: record.metrics ) {
+        if( value )
+            std::cout << "\t" << *value;
+        else
+            std::cout << "\tn/a";
+    }
+    std::cout << std::endl;
+
+    if( json_out.is_open() )
+        jps::write_json( json_out, metadata, record );
+    if( csv_out.is_open() )
+        jps::write_csv( csv_out, metadata, record );
+}
+
+/*
+ * CPU time of the calling thread in ns.
+ */
+double thread_cpu_ns() {
+    timespec ts;
+    clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts );
+    return double( ts.tv_sec ) * 1e9 + double( ts.tv_nsec );
+}
+
+/*
+ * Wake-up from wait(): n_waiters threads wait() for the value of a single variable to change while n_loaders
+ * threads load() it continuously. In every round, once all waiters are about to wait and another wait_settle_time
+ * has passed for them to block, the notifier stores an object stamped with the time stamp counter and calls
+ * notify_all(). Every waiter waits until it loads the new value, calling wait() again whenever it returned with the
+ * value unchanged, and records the time from the stamp until then, the cpu time spent and the returns from wait()
+ * without a change. The throughput is the number of waiters divided by the time until the last one woke up.
+ */
+template<class SPTR, class ASPTR>
+jps::point_record measure_wake( const std::string& lib, size_t n_waiters, size_t n_loaders ) {
+    struct alignas( 128 ) waiter_result {
+        jps::log_histogram latencies;
+        double cpu_ns = 0.;
+        size_t returns = 0;         ///< from wait(), including those with the value unchanged
+        uint64_t woken_at = 0;
+    };
+    ASPTR asp;
+    asp.store( SPTR{ new test{ jps::ticks() }} );
+    std::vector<waiter_result> results( n_waiters );
+    std::atomic<size_t> ready{ 0 };
+    std::atomic<size_t> woken{ 0 };
+    std::atomic<size_t> round{ 0 };
+    std::atomic<bool> stop{ false };
+
+    std::vector<std::thread> threads;
+    for( auto l = 0u; l < n_loaders; ++l ) {
+        threads.emplace_back( [&] {
+            [[maybe_unused]] volatile uint64_t sink;
+            while( !stop.load( std::memory_order_relaxed ))
+                sink = asp.load( std::memory_order_acquire )->u;
+        } );
+    }
+    for( auto w = 0u; w < n_waiters; ++w ) {
+        threads.emplace_back( [&, w] {
+            auto& result = results[w];
+            for( auto r = 0u; r < wait_rounds; ++r ) {
+                const auto old = asp.load( std::memory_order_acquire );
+                ready.fetch_add( 1, std::memory_order_release );
+                const auto cpu = thread_cpu_ns();
+                SPTR cur;
+                do {
+                    asp.wait( old, std::memory_order_acquire );
+                    ++result.returns;
+                    cur = asp.load( std::memory_order_acquire );
+                } while( cur == old );
+                const auto now = jps::ticks();
+                result.cpu_ns += thread_cpu_ns() - cpu;
+                result.latencies.record( now > cur->u? now - cur->u : 0 );
+                result.woken_at = now;
+                woken.fetch_add( 1, std::memory_order_release );
+                while( round.load( std::memory_order_acquire ) == r )
+                    std::this_thread::yield();
+            }
+        } );
+    }
+
+    const auto ticks1 = jps::ticks();
+    const auto time1 = std::chrono::steady_clock::now();
+    std::vector<uint64_t> last_wake_ticks;
+    for( auto r = 0u; r < wait_rounds; ++r ) {
+        while( ready.load( std::memory_order_acquire ) < n_waiters )
+            std::this_thread::yield();
+        std::this_thread::sleep_for( wait_settle_time );
+
+        SPTR stamped{ new test{ jps::ticks() }};
+        const auto stamp = stamped->u;
+        asp.store( std::move( stamped ), std::memory_order_release );
+        asp.notify_all();
+
+        while( woken.load( std::memory_order_acquire ) < n_waiters )
+            std::this_thread::yield();
+        uint64_t last = stamp;
+        for( auto& result: results )
+            last = std::max( last, result.woken_at );
+        last_wake_ticks.push_back( last - stamp );
+
+        ready.store( 0, std::memory_order_relaxed );
+        woken.store( 0, std::memory_order_relaxed );
+        round.store( r+1, std::memory_order_release );
+    }
+    stop.store( true, std::memory_order_relaxed );
+    for( auto& t: threads )
+        t.join();
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - time1;
+    const auto ticks_per_ns = double( jps::ticks() - ticks1 ) / elapsed.count();
+
+    jps::log_histogram latencies;
+    double cpu_ns = 0.;
+    size_t returns = 0;
+    for( auto& result: results ) {
+        latencies.merge( result.latencies );
+        cpu_ns += result.cpu_ns;
+        returns += result.returns;
+    }
+    std::vector<double> throughputs;
+    double last_wake_us = 0.;
+    for( auto ticks: last_wake_ticks ) {
+        const auto us = double( std::max<uint64_t>( ticks, 1 )) / ticks_per_ns / 1000.;
+        throughputs.push_back( double( n_waiters ) / us );
+        last_wake_us += us / double( last_wake_ticks.size() );
+    }
+    const auto us = [&]( uint64_t ticks ) { return double( ticks ) / ticks_per_ns / 1000.; };
+    return { lib, current_operation, true, 1, n_waiters, jps::summarize( throughputs ),
+             { { "wake_p50_us", us( latencies.percentile( .5 )) }, { "wake_p99_us", us( latencies.percentile( .99 )) },
+               { "wake_max_us", us( latencies.max() ) }, { "last_wake_us", last_wake_us },
+               { "waiter_cpu_us", cpu_ns / double( latencies.count() ) / 1000. },
+               { "unchanged_returns", double( returns - latencies.count() ) / double( latencies.count() ) } } };
+}
+
+template<class SPTR, class ASPTR>
+void test_wake_lib( const std::string& lib, size_t n_loaders ) {
+    begin_records( lib, { "wake_p50_us", "wake_p99_us", "wake_max_us", "last_wake_us", "waiter_cpu_us",
+                          "unchanged_returns" } );
+    for( auto n_waiters: waiters_grid )
+        report_record( measure_wake<SPTR, ASPTR>( lib, n_waiters, n_loaders ));
+    std::cout << std::endl;
+}
+
+/*
+ * Runs the wake-up benchmark for every number of loaders in loaders_grid with the libraries supporting wait()
+ * and notify_all().
+ */
+void test_wake() {
+    for( auto n_loaders: loaders_grid ) {
+        begin_operation( "wait_notify(loaders=" + std::to_string( n_loaders ) + ")" );
+#ifdef MEASURE_JPS
+        if( measure_aios )
+            test_wake_lib<jps::shared_ptr<test>, jps::atomic_shared_ptr<test>>( "jps", n_loaders );
+#endif
+#ifdef MEASURE_STD
+        if( measure_std )
+            test_wake_lib<std::shared_ptr<test>, std::atomic<std::shared_ptr<test>>>( "std", n_loaders );
+#endif
+    }
+}
+
+/*
+ * Re-executes an operation trace (see trace.h) with one thread per traced thread on trace.n_slots variables, with
+ * the original timing of each thread's operations (relative to a common start) or at maximum speed. Stores,
+ * exchanges and CASs publish a fresh object with a payload of the recorded size (null for size 0); a CAS expects
+ * the value the thread last loaded or got from the variable. Every replay is repeated min_trials times; besides
+ * the throughput, it reports the time of a replay and, with the original timing, how late the operations started.
+ */
+template<class SPTR, class ASPTR>
+jps::point_record replay( const std::string& lib, const jps::trace& trace ) {
+    struct replay_object {
+        explicit replay_object( size_t size ) : payload( new char[size] )
+        {}
+        uint64_t u = 0;
+        std::unique_ptr<char[]> payload;
+    };
+    using object_sptr = typename rebind_ptr<SPTR, replay_object>::type;
+    using object_asptr = typename rebind_ptr<ASPTR, replay_object>::type;
+    struct alignas( 128 ) object_slot {
+        object_asptr asp_;
+    };
+    struct alignas( 128 ) thread_lag {
+        jps::log_histogram ns;
+    };
+    const auto make = []( uint32_t size ) { return size? object_sptr{ new replay_object{ size }} : object_sptr{}; };
+
+    size_t n_events = 0;
+    for( auto& events: trace.threads )
+        n_events += events.size();
+
+    std::vector<double> throughputs;
+    double elapsed_ms = 0.;
+    jps::log_histogram lag;
+    for( auto trial = 0u; trial < min_trials; ++trial ) {
+        std::vector<object_slot> slots( trace.n_slots );
+        std::vector<thread_lag> lags( trace.threads.size() );
+        std::atomic<bool> go{ false };
+        const auto start = std::chrono::steady_clock::now() + 10ms;
+
+        std::vector<std::thread> threads;
+        for( auto t = 0u; t < trace.threads.size(); ++t ) {
+            threads.emplace_back( [&, t] {
+                std::vector<object_sptr> seen( trace.n_slots );
+                while( !go.load( std::memory_order_acquire ))
+                    std::this_thread::yield();
+                for( auto& e: trace.threads[t] ) {
+                    if( replay_original_timing ) {
+                        const auto due = start + std::chrono::nanoseconds( e.ns );
+                        if( due - std::chrono::steady_clock::now() > 200us )
+                            std::this_thread::sleep_until( due - 100us );
+                        auto now = std::chrono::steady_clock::now();
+                        while( now < due )
+                            now = std::chrono::steady_clock::now();
+                        lags[t].ns.record( uint64_t(( now - due ).count() ));
+                    }
+                    auto& asp = slots[e.slot].asp_;
+                    switch( e.op() ) {
+                        case jps::trace_op::load:
+                            seen[e.slot] = asp.load( std::memory_order_acquire );
+                            break;
+                        case jps::trace_op::store:
+                            asp.store( make( e.size() ), std::memory_order_release );
+                            break;
+                        case jps::trace_op::exchange:
+                            seen[e.slot] = asp.exchange( make( e.size() ), std::memory_order_acq_rel );
+                            break;
+                        case jps::trace_op::cas_weak:
+                            asp.compare_exchange_weak( seen[e.slot], make( e.size() ),
+                                                       std::memory_order_acq_rel, std::memory_order_acquire );
+                            break;
+                        case jps::trace_op::cas_strong:
+                            asp.compare_exchange_strong( seen[e.slot], make( e.size() ),
+                                                         std::memory_order_acq_rel, std::memory_order_acquire );
+                            break;
+                    }
+                }
+            } );
         }
+        std::this_thread::sleep_until( start );
+        const auto begin = std::chrono::steady_clock::now();
+        go.store( true, std::memory_order_release );
+        for( auto& t: threads )
+            t.join();
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - begin;
+
+        throughputs.push_back( double( n_events ) / elapsed.count() );
+        elapsed_ms += elapsed.count() / 1000. / double( min_trials );
+        for( auto& l: lags )
+            lag.merge( l.ns );
+    }
+
+    std::vector<std::pair<std::string, std::optional<double>>> metrics = { { "elapsed_ms", elapsed_ms } };
+    for( auto [name, p]: { std::pair{ "late_p50_us", .5 }, { "late_p99_us", .99 }, { "late_max_us", 1. } } ) {
+        if( replay_original_timing )
+            metrics.emplace_back( name, double( p < 1.? lag.percentile( p ) : lag.max() ) / 1000. );
+        else
+            metrics.emplace_back( name, std::nullopt );
+    }
+    return { lib, current_operation, true, trace.n_slots, trace.threads.size(), jps::summarize( throughputs ),
+             metrics };
+}
+
+template<class SPTR, class ASPTR>
+void test_replay_lib( const std::string& lib, const jps::trace& trace ) {
+    begin_records( lib, { "elapsed_ms", "late_p50_us", "late_p99_us", "late_max_us" } );
+    report_record( replay<SPTR, ASPTR>( lib, trace ));
+    std::cout << std::endl;
+}
+
+/*
+ * Replays the trace replay_path with every selected library.
+ */
+void test_replay() {
+    jps::trace trace;
+    try {
+        trace = jps::read_trace( replay_path );
     }
+    catch( const std::runtime_error& e ) {
+        std::cerr << e.what() << "\n";
+        exit( -1 );
+    }
+    begin_operation( "replay(" + replay_path + ";" + ( replay_original_timing? "original" : "max" ) + ")" );
+#ifdef MEASURE_JPS
+    if( measure_aios )
+        test_replay_lib<jps::shared_ptr<test>, jps::atomic_shared_ptr<test>>( "jps", trace );
+#endif
+#ifdef MEASURE_STD
+    if( measure_std )
+        test_replay_lib<std::shared_ptr<test>, std::atomic<std::shared_ptr<test>>>( "std", trace );
+#endif
+#ifdef MEASURE_BOOST
+    if( measure_boost )
+        test_replay_lib<boost::shared_ptr<test>, boost::atomic_shared_ptr<test>>( "boost", trace );
+#endif
+#ifdef MEASURE_BASELINES
+    if( measure_mutex )
+        test_replay_lib<std::shared_ptr<test>, jps::baseline::mutex_atomic_shared_ptr<test>>( "mutex", trace );
+    if( measure_striped )
+        test_replay_lib<std::shared_ptr<test>, jps::baseline::striped_atomic_shared_ptr<test>>( "striped", trace );
+    if( measure_hazard )
+        test_replay_lib<std::shared_ptr<test>, jps::baseline::hazard_atomic_shared_ptr<test>>( "hazard", trace );
 #endif
 }
 
-void run_all()
+/*
+ * The operations on the variables of SptrExperiment, which are swept over the strides of -stride.
+ */
+void run_slot_operations()
 {
-    const size_t repeat = 1;
+    const size_t at_least_trials = min_trials;
 
 #ifdef MEASURE_STORE
     if( measure_store ) {
-        std::cout << "=== operation: store\n";
-        test_op<e_store>( repeat );
+        begin_operation( "store" );
+        test_op<e_store>( at_least_trials );
     }
 #endif
 
 #ifdef MEASURE_LOAD
     if( measure_load ) {
-        std::cout << "=== operation: load\n";
-        test_op<e_load>( repeat );
+        begin_operation( "load" );
+        test_op<e_load>( at_least_trials );
     }
 #endif
 
 #ifdef MEASURE_EXCHANGE
     if( measure_exchange ) {
-        std::cout << "=== operation: exchange\n";
-        test_op<e_exchange>( repeat );
+        begin_operation( "exchange" );
+        test_op<e_exchange>( at_least_trials );
     }
 #endif
 
 #ifdef MEASURE_CAS_WEAK
     if( measure_cas_weak ) {
-        std::cout << "=== operation: cas_weak\n";
-        test_op<e_cas_weak>( repeat );
+        begin_operation( "cas_weak" );
+        test_op<e_cas_weak>( at_least_trials );
     }
 #endif
 
 #ifdef MEASURE_CAS_STRONG
     if( measure_cas_strong) {
-        std::cout << "=== operation: cas_strong\n";
-        test_op<e_cas_strong>( repeat );
+        begin_operation( "cas_strong" );
+        test_op<e_cas_strong>( at_least_trials );
     }
 #endif
 
 #ifdef MEASURE_CAS_WEAK_LOOP
     if( measure_cas_weak_loop ) {
-        std::cout << "=== operation: cas_weak_loop\n";
-        test_op<e_cas_weak_loop>( repeat );
+        begin_operation( "cas_weak_loop" );
+        test_op<e_cas_weak_loop>( at_least_trials );
     }
 #endif
 
 #ifdef MEASURE_CAS_STRONG_LOOP
     if( measure_cas_strong_loop ) {
-        std::cout << "=== operation: cas_strong_loop\n";
-        test_op<e_cas_strong_loop>( repeat );
+        begin_operation( "cas_strong_loop" );
+        test_op<e_cas_strong_loop>( at_least_trials );
+    }
+#endif
+
+#ifdef MEASURE_MIXED
+    if( measure_mixed ) {
+        begin_operation( "mixed(" + mix_spec + ";" + dist_spec + ")" );
+        test_op<e_mixed>( at_least_trials );
+    }
+#endif
+
+#ifdef MEASURE_CONFIG_RELOAD
+    if( measure_config_reload ) {
+        begin_operation( "config_reload" );
+        test_op<e_config_reload>( at_least_trials );
+    }
+#endif
+
+#ifdef MEASURE_HANDOFF
+    if( measure_handoff ) {
+        begin_operation( "handoff" );
+        test_op<e_handoff>( at_least_trials );
+    }
+#endif
+
+#ifdef MEASURE_COUNTER
+    if( measure_counter ) {
+        begin_operation( "counter" );
+        test_op<e_counter>( at_least_trials );
+    }
+#endif
+
+#ifdef MEASURE_PROPAGATION
+    if( measure_propagation ) {
+        begin_operation( "propagation" );
+        test_op<e_propagation>( at_least_trials );
+    }
+#endif
+}
+
+/*
+ * The operations on their own data structures, which -stride does not apply to.
+ */
+void run_other_operations()
+{
+    const size_t at_least_trials = min_trials;
+
+#ifdef MEASURE_LIST_TRAVERSAL
+    if( measure_list_traversal ) {
+        begin_operation( "list_traversal" );
+        test_op<e_list_traversal>( at_least_trials );
+    }
+#endif
+
+#ifdef MEASURE_CHURN
+    if( measure_churn ) {
+        begin_operation( "churn_" + std::to_string( churn_size ));
+        [&]<size_t... sizes>( std::index_sequence<sizes...> ) {
+            (( churn_size == churn_sizes[sizes]
+               ? test_op<churn_experiment<churn_sizes[sizes]>::template type>( at_least_trials )
+               : void() ), ... );
+        }( std::make_index_sequence<std::size( churn_sizes )>() );
     }
 #endif
+
+#ifdef MEASURE_RECLAIM
+    if( measure_reclaim ) {
+        begin_operation( "reclaim_store" );
+        test_op<reclaim_experiment<false>::template type>( at_least_trials );
+        begin_operation( "reclaim_exchange" );
+        test_op<reclaim_experiment<true>::template type>( at_least_trials );
+    }
+#endif
+
+#ifdef MEASURE_WAIT_NOTIFY
+    if( measure_wait_notify )
+        test_wake();
+#endif
+
+    if( !replay_path.empty() )
+        test_replay();
+
+#ifdef MEASURE_SPTR
+    [&]<size_t... ops>( std::index_sequence<ops...> ) {
+        ( [&] {
+            if( measure_sptr_op[ops] ) {
+                begin_operation( sptr_op_names[ops] );
+                test_sptr_libs<sptr_experiment<sptr_op( ops )>::template type>( at_least_trials );
+            }
+        }(), ... );
+    }( std::make_index_sequence<n_sptr_ops>() );
+#endif
+}
+
+void run_all()
+{
+    std::cout << "=== pinning: " << metadata.pinning << "\n";
+    report_harness_overhead();
+
+    if( stride_grid.empty() )
+        run_slot_operations();
+    for( auto stride: stride_grid ) {
+        slot_stride = stride;
+        sweeping_stride = true;
+        run_slot_operations();
+        sweeping_stride = false;
+    }
+    run_other_operations();
 }
 
 int main( int argc, char* argv[] ) {
+    bool latency_given = false;
     for( auto i = 1; i < argc; ++i ) {
         const auto s = std::string( argv[i] );
+        // the grid of the next argument, exiting if it is invalid
+        const auto grid_arg = [&]( const char* name, size_t min = 1 ) {
+            const auto grid = jps::parse_grid( argv[++i], min );
+            if( !grid ) {
+                std::cerr << "Invalid " << name << ": " << argv[i] << "\n";
+                exit( -1 );
+            }
+            return *grid;
+        };
 
         if( s == "-std" )
             measure_std = false;
@@ -420,12 +2046,42 @@ int main( int argc, char* argv[] ) {
             measure_vtyulb = false;
         else if( s == "-jps" )
             measure_aios = false;
+        else if( s == "-boost" )
+            measure_boost = false;
+        else if( s == "-mutex" )
+            measure_mutex = false;
+        else if( s == "-striped" )
+            measure_striped = false;
+        else if( s == "-hazard" )
+            measure_hazard = false;
         else if( s == "-default_lib" ) {
             measure_std = false;
             measure_vtyulb = false;
             measure_jss = false;
             measure_folly = false;
             measure_aios = false;
+            measure_boost = false;
+            measure_mutex = false;
+            measure_striped = false;
+            measure_hazard = false;
+        }
+        else if( s == "-lib" && i+1 < argc ) {
+            for( auto& [name, flag]: libraries )
+                *flag = false;
+            std::stringstream names( argv[++i] );
+            std::string name;
+            while( std::getline( names, name, ',' )) {
+                const auto lib = std::find_if( std::begin( libraries ), std::end( libraries ),
+                                               [&]( auto& l ) { return name == l.first; } );
+                if( lib == std::end( libraries )) {
+                    std::cerr << "Unknown library: " << name << " (known:";
+                    for( auto& l: libraries )
+                        std::cerr << " " << l.first;
+                    std::cerr << ")\n";
+                    exit( -1 );
+                }
+                *lib->second = true;
+            }
         }
 
         else if( s == "-store" )
@@ -450,6 +2106,16 @@ int main( int argc, char* argv[] ) {
             measure_cas_strong = false;
             measure_cas_weak_loop = false;
             measure_cas_strong_loop = false;
+            measure_mixed = false;
+            measure_config_reload = false;
+            measure_handoff = false;
+            measure_list_traversal = false;
+            measure_counter = false;
+            measure_churn = false;
+            measure_reclaim = false;
+            measure_wait_notify = false;
+            measure_propagation = false;
+            std::fill( std::begin( measure_sptr_op ), std::end( measure_sptr_op ), false );
         }
 
         else if( s == "+std" )
@@ -462,6 +2128,14 @@ int main( int argc, char* argv[] ) {
             measure_vtyulb = true;
         else if( s == "+jps" )
             measure_aios = true;
+        else if( s == "+boost" )
+            measure_boost = true;
+        else if( s == "+mutex" )
+            measure_mutex = true;
+        else if( s == "+striped" )
+            measure_striped = true;
+        else if( s == "+hazard" )
+            measure_hazard = true;
 
         else if( s == "+store" )
             measure_store = true;
@@ -477,6 +2151,105 @@ int main( int argc, char* argv[] ) {
             measure_cas_weak_loop = true;
         else if( s == "+cas_strong_loop" )
             measure_cas_strong_loop = true;
+        else if( s == "+mixed" )
+            measure_mixed = true;
+        else if( s == "-mixed" )
+            measure_mixed = false;
+        else if( s == "+config_reload" )
+            measure_config_reload = true;
+        else if( s == "-config_reload" )
+            measure_config_reload = false;
+        else if( s == "+handoff" )
+            measure_handoff = true;
+        else if( s == "-handoff" )
+            measure_handoff = false;
+        else if( s == "+list_traversal" )
+            measure_list_traversal = true;
+        else if( s == "-list_traversal" )
+            measure_list_traversal = false;
+        else if( s == "+counter" )
+            measure_counter = true;
+        else if( s == "-counter" )
+            measure_counter = false;
+        else if( s == "+scenarios" ) {
+            measure_config_reload = true;
+            measure_handoff = true;
+            measure_list_traversal = true;
+            measure_counter = true;
+        }
+        else if( s == "+sptr" || s == "-sptr" )
+            std::fill( std::begin( measure_sptr_op ), std::end( measure_sptr_op ), s[0] == '+' );
+        else if(( s[0] == '+' || s[0] == '-' )
+                && std::find( std::begin( sptr_op_names ), std::end( sptr_op_names ), s.substr( 1 ))
+                   != std::end( sptr_op_names ))
+            measure_sptr_op[std::find( std::begin( sptr_op_names ), std::end( sptr_op_names ), s.substr( 1 ))
+                            - std::begin( sptr_op_names )] = s[0] == '+';
+        else if( s == "+churn" )
+            measure_churn = true;
+        else if( s == "-churn" )
+            measure_churn = false;
+        else if( s == "+reclaim" )
+            measure_reclaim = true;
+        else if( s == "-reclaim" )
+            measure_reclaim = false;
+        else if( s == "+wait_notify" )
+            measure_wait_notify = true;
+        else if( s == "-wait_notify" )
+            measure_wait_notify = false;
+        else if( s == "+propagation" )
+            measure_propagation = true;
+        else if( s == "-propagation" )
+            measure_propagation = false;
+        else if( s == "-publish_ns" && i+1 < argc )
+            publish_interval = std::chrono::nanoseconds( std::atol( argv[++i] ));
+        else if( s == "-waiters" && i+1 < argc )
+            waiters_grid = grid_arg( "waiters" );
+        else if( s == "-loaders" && i+1 < argc )
+            loaders_grid = grid_arg( "loaders", 0 );
+        else if( s == "-wait_rounds" && i+1 < argc )
+            wait_rounds = std::max( std::atoi( argv[++i] ), 1 );
+        else if( s == "-stride" && i+1 < argc )
+            stride_grid = grid_arg( "stride" );
+        else if( s == "-replay" && i+1 < argc )
+            replay_path = argv[++i];
+        else if( s == "-replay_timing" && i+1 < argc ) {
+            const auto timing = std::string( argv[++i] );
+            if( timing != "original" && timing != "max" ) {
+                std::cerr << "Unknown replay timing: " << timing << "\n";
+                exit( -1 );
+            }
+            replay_original_timing = timing == "original";
+        }
+        else if( s == "-churn_size" && i+1 < argc ) {
+            churn_size = std::atoi( argv[++i] );
+            if( std::find( std::begin( churn_sizes ), std::end( churn_sizes ), churn_size ) == std::end( churn_sizes )) {
+                std::cerr << "Unsupported churn size: " << churn_size << " (supported: 16, 64, 256, 1024, 4096)\n";
+                exit( -1 );
+            }
+        }
+        else if( s == "-churn_work" && i+1 < argc )
+            churn_dtor_work = std::atoi( argv[++i] );
+        else if( s == "-memory_trace" && i+1 < argc )
+            memory_trace.open( argv[++i], std::ios::app );
+        else if( s == "-reload_every" && i+1 < argc )
+            reload_every = std::max( std::atoi( argv[++i] ), 1 );
+        else if( s == "-mix" && i+1 < argc ) {
+            mix_spec = argv[++i];
+            if( !parse_mix( mix_spec )) {
+                std::cerr << "Invalid mix: " << mix_spec << "\n";
+                exit( -1 );
+            }
+            measure_mixed = true;
+        }
+        else if( s == "-dist" && i+1 < argc ) {
+            dist_spec = argv[++i];
+            const auto zipf_s = jps::parse_distribution( dist_spec );
+            if( !zipf_s ) {
+                std::cerr << "Invalid distribution: " << dist_spec << " (expected uniform or zipf:<s>, s >= 0)\n";
+                exit( -1 );
+            }
+            dist_zipf_s = *zipf_s;
+        }
 
         else if( s == "-contention" )
             measure_with_contention = false;
@@ -487,14 +2260,100 @@ int main( int argc, char* argv[] ) {
         else if( s == "+no_contention" )
             measure_without_contention = true;
 
-        else if( s == "-workers")
+        else if( s == "-workers" && i+1 < argc && std::string( argv[i+1] ).find( ',' ) != std::string::npos )
+            workers_grid = grid_arg( "workers" );
+        else if( s == "-vars" && i+1 < argc && std::string( argv[i+1] ).find( ',' ) != std::string::npos )
+            vars_grid = grid_arg( "vars" );
+        else if( s == "-workers" && i+1 < argc )
             min_workers = std::atoi( argv[++i] );
-        else if( s == "-vars")
+        else if( s == "-vars" && i+1 < argc )
             min_vars = std::atoi( argv[++i] );
-        else if( s == "+workers")
+        else if( s == "+workers" && i+1 < argc )
             max_workers = std::atoi( argv[++i] );
-        else if( s == "+vars")
+        else if( s == "+vars" && i+1 < argc )
             max_vars = std::atoi( argv[++i] );
+        else if( s == "-pin" && i+1 < argc ) {
+            pin_policy = argv[++i];
+            if( pin_policy == "list" && i+1 >= argc ) {
+                std::cerr << "Missing cpu list for -pin list\n";
+                exit( -1 );
+            }
+            try {
+                pin_cpus = jps::placement( pin_policy, pin_policy == "list"? argv[++i] : "" );
+            } catch( const std::invalid_argument& e ) {
+                std::cerr << "Invalid placement: " << e.what() << "\n";
+                exit( -1 );
+            }
+            if( pin_cpus.empty() ) {
+                std::cerr << "Unknown or empty placement: " << pin_policy << "\n";
+                exit( -1 );
+            }
+            for( auto c: pin_cpus )
+                if( !jps::cpu_available( c )) {
+                    std::cerr << "Invalid placement: cpu " << c << " is not available\n";
+                    exit( -1 );
+                }
+        }
+        else if( s == "-perf" ) {
+            const auto defaults = jps::default_perf_events();
+            perf_events.insert( perf_events.end(), defaults.begin(), defaults.end() );
+        }
+        else if( s == "-perf_raw" && i+1 < argc )
+            perf_events.push_back( jps::parse_raw_perf_event( argv[++i] ));
+        else if( s == "-grid" && i+1 < argc ) {
+            const auto grid = std::string( argv[++i] );
+            if( grid != "linear" && grid != "geometric" ) {
+                std::cerr << "Unknown grid: " << grid << "\n";
+                exit( -1 );
+            }
+            geometric_grid = grid == "geometric";
+        }
+        else if( s == "-checkpoint" && i+1 < argc )
+            checkpoint = jps::sweep_checkpoint( argv[++i] );
+        else if( s == "-json" && i+1 < argc )
+            json_out.open( argv[++i], std::ios::app );
+        else if( s == "-csv" && i+1 < argc ) {
+            csv_out.open( argv[++i], std::ios::app );
+            if( csv_out.tellp() == 0 )
+                jps::write_csv_header( csv_out );
+        }
+        else if( s == "-warmup_ms" && i+1 < argc )
+            warmup_time = std::chrono::milliseconds( std::atoi( argv[++i] ));
+        else if( s == "-stalls" )
+            measure_stalls = true;
+        else if( s == "-steady" && i+1 < argc )
+            steady_tolerance = std::atof( argv[++i] );
+        else if( s == "-sample_ms" && i+1 < argc )
+            sample_period = std::chrono::milliseconds( std::max( std::atoi( argv[++i] ), 1 ));
+        else if( s == "-max_warmup_ms" && i+1 < argc )
+            max_warmup_time = std::chrono::milliseconds( std::atoi( argv[++i] ));
+        else if( s == "-timeseries" && i+1 < argc )
+            timeseries_out.open( argv[++i], std::ios::app );
+        else if( s == "-trial_ms" && i+1 < argc )
+            trial_time = std::chrono::milliseconds( std::atoi( argv[++i] ));
+        else if( s == "-max_ms" && i+1 < argc )
+            max_time_per_point = std::chrono::milliseconds( std::atoi( argv[++i] ));
+        else if( s == "-ci" && i+1 < argc )
+            target_rel_ci = std::atof( argv[++i] );
+        else if( s == "-min_trials" && i+1 < argc )
+            min_trials = std::max( std::atoi( argv[++i] ), 1 );
+        else if( s == "-latency" && i+1 < argc ) {
+            latency_sample_every = std::atoi( argv[++i] );
+            latency_given = true;
+        }
+        else if( s == "-oversubscribe" && i+1 < argc )
+            oversubscribe = std::max( std::atoi( argv[++i] ), 1 );
+#ifdef MEASURE_PREEMPT
+        else if( s == "-preempt" && i+1 < argc )
+            jps::preemption.probability = std::atof( argv[++i] );
+        else if( s == "-preempt_sleep_us" && i+1 < argc )
+            jps::preemption.sleep_us = std::atoi( argv[++i] );
+#else
+        else if( s == "-preempt" || s == "-preempt_sleep_us" ) {
+            std::cerr << s << " needs the preemption points of measure_preempt\n";
+            exit( -1 );
+        }
+#endif
 
         else {
             std::cerr << "Unknown parameter: " << s << "\n";
@@ -502,5 +2361,25 @@ int main( int argc, char* argv[] ) {
         }
     }
 
+    if( workers_grid.empty() && oversubscribe ) {
+        const size_t cpus = pin_cpus.empty()? std::max( std::thread::hardware_concurrency(), 1u ) : pin_cpus.size();
+        for( auto k = 1u; k <= oversubscribe; ++k )
+            workers_grid.push_back( k * cpus );
+    }
+    if( workers_grid.empty() )
+        workers_grid = jps::make_grid( min_workers, max_workers, geometric_grid );
+    // the effect of preemption shows in the tail latencies, sampled unless -latency says otherwise
+    if( jps::preemption.probability > 0. && !latency_given )
+        latency_sample_every = 16;
+    if( vars_grid.empty() )
+        vars_grid = jps::make_grid( min_vars, max_vars, geometric_grid );
+    pool = std::make_unique<jps::worker_pool>( pin_cpus );
+
+    std::ostringstream pinning;
+    pinning << pin_policy;
+    for( auto c: pin_cpus )
+        pinning << " " << c;
+    metadata = jps::collect_metadata( pinning.str() );
+
     run_all();
 }
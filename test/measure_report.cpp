@@ -0,0 +1,480 @@
+//
+// Generates speedup and scaling efficiency tables and gnuplot-ready data files from the JSON output of measure.
+//
+// Usage: measure_report [-baseline <library>] [-metric <name>] [-gnuplot <prefix>] [-usl] <results.jsonl>...
+//        measure_report -check <baseline.jsonl> [-tolerance <metric>=<relative>]... <results.jsonl>...
+//
+// With -usl, the Universal Scalability Law is fitted to each library's curve over the threads (per operation,
+// contention and vars), reporting its parameters, the thread count and value of the predicted peak and the R^2.
+//
+// With -check, the results are compared against the baseline instead, and the exit code is 1 if any metric is worse
+// than its baseline by more than its tolerance (default: throughput_mean=0.25). Baseline throughputs whose confidence
+// interval is wider than half the tolerance are too noisy to tell a regression and are not checked.
+//
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "results.h"
+
+
+std::string baseline = "std";
+std::string metric = "throughput_mean";
+std::string gnuplot_prefix;
+bool fit_usl_curves = false;
+
+// (operation, contention) -> (vars, threads) -> library -> value
+using experiment_key = std::tuple<std::string, std::string>;
+using point_key = std::tuple<size_t, size_t>;
+std::map<experiment_key, std::map<point_key, std::map<std::string, double>>> results;
+
+void read_results( const std::string& path ) {
+    std::ifstream in( path );
+    if( !in ) {
+        std::cerr << "Cannot read " << path << "\n";
+        exit( -1 );
+    }
+
+    for( std::string line; std::getline( in, line ); ) {
+        auto values = jps::parse_json_line( line );
+        if( values.count( "operation" ) == 0 || values.count( metric ) == 0 || values[metric] == "null" )
+            continue;
+
+        const experiment_key e{ values["operation"], values["contention"] == "true"? "contention" : "no_contention" };
+        const point_key p{ std::stoul( values["vars"] ), std::stoul( values["threads"] ) };
+        results[e][p][values["library"]] = std::stod( values[metric] );   // a later record replaces an earlier one
+    }
+}
+
+/*
+ * Scaling efficiency of a library at a point: value( t ) / ( t/t0 * value( t0 )), where t0 is the smallest thread
+ * count measured for the same number of variables.
+ */
+std::optional<double> efficiency( const std::map<point_key, std::map<std::string, double>>& points,
+                                  const point_key& p, const std::string& lib ) {
+    const auto& [vars, threads] = p;
+    for( auto& [q, libs]: points ) {
+        if( std::get<0>( q ) != vars )
+            continue;
+        const auto it = libs.find( lib );
+        if( it == libs.end() || it->second <= 0. )
+            continue;
+
+        // the first match is the smallest thread count for these vars
+        const auto t0 = std::get<1>( q );
+        return points.at( p ).at( lib ) / ( double( threads ) / double( t0 ) * it->second );
+    }
+    return std::nullopt;
+}
+
+/*
+ * The name with every character but [A-Za-z0-9_-] replaced by '_', for use in a file name.
+ */
+std::string file_name_part( const std::string& name ) {
+    std::string part = name;
+    for( auto& c: part )
+        if( !std::isalnum( static_cast<unsigned char>( c )) && c != '_' && c != '-' )
+            c = '_';
+    return part;
+}
+
+void report( const experiment_key& e, const std::map<point_key, std::map<std::string, double>>& points ) {
+    std::set<std::string> libs;
+    for( auto& [p, values]: points )
+        for( auto& [lib, value]: values )
+            libs.insert( lib );
+    const bool has_baseline = libs.count( baseline ) != 0;
+
+    std::cout << "=== operation: " << std::get<0>( e ) << ", " << std::get<1>( e ) << " (" << metric << ")\n";
+    std::cout << "vars\tthreads";
+    for( auto& lib: libs )
+        std::cout << "\t" << lib;
+    if( has_baseline )
+        for( auto& lib: libs )
+            if( lib != baseline )
+                std::cout << "\t" << lib << "/" << baseline;
+    for( auto& lib: libs )
+        std::cout << "\teff(" << lib << ")";
+    std::cout << "\n";
+
+    std::ofstream dat;
+    if( !gnuplot_prefix.empty() ) {
+        dat.open( gnuplot_prefix + "-" + file_name_part( std::get<0>( e )) + "-" + file_name_part( std::get<1>( e ))
+                  + ".dat" );
+        dat << "# vars threads";
+        for( auto& lib: libs )
+            dat << " " << lib;
+        dat << "\n";
+    }
+
+    size_t last_vars = 0;
+    for( auto& [p, values]: points ) {
+        const auto value = [&]( const std::string& lib ) -> std::optional<double> {
+            const auto it = values.find( lib );
+            return it == values.end()? std::nullopt : std::optional<double>( it->second );
+        };
+        const auto print = [&]( std::ostream& out, std::optional<double> v, const char* sep ) {
+            out << sep;
+            if( v )
+                out << *v;
+            else
+                out << "-";
+        };
+
+        std::cout << std::get<0>( p ) << "\t" << std::get<1>( p );
+        for( auto& lib: libs )
+            print( std::cout, value( lib ), "\t" );
+        if( has_baseline ) {
+            for( auto& lib: libs ) {
+                if( lib == baseline )
+                    continue;
+                const auto v = value( lib );
+                const auto b = value( baseline );
+                print( std::cout, v && b && *b > 0.? std::optional<double>( *v / *b ) : std::nullopt, "\t" );
+            }
+        }
+        for( auto& lib: libs )
+            print( std::cout, value( lib )? efficiency( points, p, lib ) : std::nullopt, "\t" );
+        std::cout << "\n";
+
+        if( dat.is_open() ) {
+            // separate the blocks of different vars for gnuplot's splot
+            if( last_vars != 0 && last_vars != std::get<0>( p ))
+                dat << "\n";
+            last_vars = std::get<0>( p );
+            dat << std::get<0>( p ) << " " << std::get<1>( p );
+            for( auto& lib: libs )
+                print( dat, value( lib ), " " );
+            dat << "\n";
+        }
+    }
+    std::cout << std::endl;
+}
+
+/*
+ * The Universal Scalability Law X( N ) = lambda N / ( 1 + sigma ( N-1 ) + kappa N ( N-1 )) fitted to the throughput
+ * of N threads: lambda is the throughput of one thread without contention, sigma the contention (serialized
+ * share) and kappa the coherency (crosstalk) penalty.
+ */
+struct usl_fit {
+    double lambda = 0.;
+    double sigma = 0.;
+    double kappa = 0.;
+    double r2 = 0.;         ///< coefficient of determination of the fitted throughputs
+    size_t n_points = 0;
+
+    double operator()( double n ) const {
+        return lambda * n / ( 1. + sigma * ( n-1. ) + kappa * n * ( n-1. ));
+    }
+    /*
+     * The thread count of the maximum throughput; infinite without coherency penalty.
+     */
+    double peak_threads() const {
+        return kappa > 0.? std::sqrt( std::max( 1.-sigma, 0. ) / kappa ) : INFINITY;
+    }
+};
+
+/*
+ * Least squares solution of rows * x = y via the normal equations; nullopt if they are singular.
+ */
+std::optional<std::vector<double>> least_squares( const std::vector<std::vector<double>>& rows,
+                                                  const std::vector<double>& y ) {
+    const auto k = rows.empty()? 0 : rows.front().size();
+    if( k == 0 || rows.size() < k )
+        return std::nullopt;
+    std::vector<std::vector<double>> a( k );
+    for( auto& row: a )
+        row.assign( k+1, 0. );
+    for( auto r = 0u; r < rows.size(); ++r ) {
+        for( auto i = 0u; i < k; ++i ) {
+            for( auto j = 0u; j < k; ++j )
+                a[i][j] += rows[r][i] * rows[r][j];
+            a[i][k] += rows[r][i] * y[r];
+        }
+    }
+    for( auto i = 0u; i < k; ++i ) {
+        auto pivot = i;
+        for( auto j = i+1; j < k; ++j )
+            if( std::abs( a[j][i] ) > std::abs( a[pivot][i] ))
+                pivot = j;
+        if( std::abs( a[pivot][i] ) < 1e-300 )
+            return std::nullopt;
+        std::swap( a[i], a[pivot] );
+        for( auto j = 0u; j < k; ++j ) {
+            if( j == i )
+                continue;
+            const auto f = a[j][i] / a[i][i];
+            for( auto c = i; c <= k; ++c )
+                a[j][c] -= f * a[i][c];
+        }
+    }
+    std::vector<double> x( k );
+    for( auto i = 0u; i < k; ++i )
+        x[i] = a[i][k] / a[i][i];
+    return x;
+}
+
+/*
+ * Fits the USL to (threads, throughput) points by linear least squares on N/X( N ) = ( 1 + sigma ( N-1 ) +
+ * kappa N ( N-1 )) / lambda. Points without a positive throughput are ignored; at least 3 must remain. All four
+ * models (with and without sigma and kappa) are fitted, and of those with non-negative parameters the one with the
+ * highest R^2 is returned.
+ */
+std::optional<usl_fit> fit_usl( const std::vector<std::pair<double, double>>& all_points ) {
+    std::vector<std::pair<double, double>> points;
+    for( auto [n, x]: all_points )
+        if( x > 0. )
+            points.emplace_back( n, x );
+    if( points.size() < 3 )
+        return std::nullopt;
+
+    std::optional<usl_fit> best;
+    for( auto [with_sigma, with_kappa]: { std::pair{ true, true }, { true, false }, { false, true }, { false, false } } ) {
+        std::vector<std::vector<double>> rows;
+        std::vector<double> y;
+        for( auto [n, x]: points ) {
+            std::vector<double> row = { 1. };
+            if( with_sigma )
+                row.push_back( n-1. );
+            if( with_kappa )
+                row.push_back( n*( n-1. ));
+            rows.push_back( row );
+            y.push_back( n / x );
+        }
+        const auto c = least_squares( rows, y );
+        if( !c || ( *c )[0] <= 0. )
+            continue;
+
+        usl_fit fit;
+        fit.lambda = 1. / ( *c )[0];
+        fit.sigma = with_sigma? ( *c )[1] / ( *c )[0] : 0.;
+        fit.kappa = with_kappa? ( *c )[with_sigma? 2 : 1] / ( *c )[0] : 0.;
+        if( fit.sigma < 0. || fit.kappa < 0. )
+            continue;
+
+        double mean = 0., ss_res = 0., ss_tot = 0.;
+        for( auto [n, x]: points )
+            mean += x / double( points.size() );
+        for( auto [n, x]: points ) {
+            ss_res += ( x - fit( n )) * ( x - fit( n ));
+            ss_tot += ( x - mean ) * ( x - mean );
+        }
+        fit.r2 = ss_tot > 0.? 1. - ss_res / ss_tot : 1.;
+        fit.n_points = points.size();
+        if( !best || fit.r2 > best->r2 )
+            best = fit;
+    }
+    return best;
+}
+
+/*
+ * Prints the USL fitted to each library's throughput over the threads, per number of variables.
+ */
+void report_usl( const experiment_key& e, const std::map<point_key, std::map<std::string, double>>& points ) {
+    // vars -> library -> (threads, value)
+    std::map<size_t, std::map<std::string, std::vector<std::pair<double, double>>>> curves;
+    for( auto& [p, values]: points )
+        for( auto& [lib, value]: values )
+            curves[std::get<0>( p )][lib].emplace_back( double( std::get<1>( p )), value );
+
+    std::cout << "=== usl: " << std::get<0>( e ) << ", " << std::get<1>( e ) << " (" << metric << ")\n"
+              << "vars\tlibrary\tlambda\tsigma\tkappa\tpeak_threads\tpeak_value\tr2\tpoints\n";
+    for( auto& [vars, libs]: curves ) {
+        for( auto& [lib, curve]: libs ) {
+            std::cout << vars << "\t" << lib;
+            const auto fit = fit_usl( curve );
+            if( !fit ) {
+                std::cout << "\t-\t-\t-\t-\t-\t-\t" << curve.size() << "\n";
+                continue;
+            }
+            const auto peak = fit->peak_threads();
+            std::cout << "\t" << fit->lambda << "\t" << fit->sigma << "\t" << fit->kappa << "\t" << peak << "\t"
+                      << ( std::isinf( peak )? fit->lambda / fit->sigma : ( *fit )( peak )) << "\t" << fit->r2
+                      << "\t" << fit->n_points << "\n";
+        }
+    }
+    std::cout << std::endl;
+}
+
+/*
+ * Identifies a point across runs: library, operation, contention, vars, threads.
+ */
+using record_key = std::tuple<std::string, std::string, std::string, size_t, size_t>;
+
+std::map<record_key, std::map<std::string, std::string>> read_records( const std::string& path ) {
+    std::ifstream in( path );
+    if( !in ) {
+        std::cerr << "Cannot read " << path << "\n";
+        exit( -1 );
+    }
+
+    std::map<record_key, std::map<std::string, std::string>> records;
+    for( std::string line; std::getline( in, line ); ) {
+        auto values = jps::parse_json_line( line );
+        if( values.count( "operation" ) == 0 )
+            continue;
+        const record_key key{ values["library"], values["operation"], values["contention"],
+                              std::stoul( values["vars"] ), std::stoul( values["threads"] ) };
+        records[key] = std::move( values );
+    }
+    return records;
+}
+
+/*
+ * Higher is better for throughputs; lower is better for everything else (latencies, events per operation, ...).
+ */
+bool higher_is_better( const std::string& metric ) {
+    return metric.rfind( "throughput", 0 ) == 0;
+}
+
+/*
+ * The run metadata a baseline is only valid for: results from another machine or build are not comparable.
+ */
+const std::vector<std::string> check_metadata{ "cpu_model", "n_cpus", "flags" };
+
+/*
+ * Outcome of check(); the exit code of measure_report -check.
+ */
+enum class check_result { ok = 0, regressed = 1, not_comparable = 2 };
+
+/*
+ * Compares the results against the baseline and prints a diff of all compared metrics. The results are not
+ * comparable if their metadata differs from the baseline's or if no metric could be compared at all.
+ */
+check_result check( const std::string& baseline_path, const std::vector<std::string>& files,
+              const std::map<std::string, double>& tolerances ) {
+    const auto base = read_records( baseline_path );
+    std::map<record_key, std::map<std::string, std::string>> current;
+    for( auto& f: files )
+        for( auto& [key, values]: read_records( f ))
+            current[key] = values;
+
+    size_t n_regressions = 0, n_compared = 0;
+    std::cout << std::left << std::setw( 44 ) << "point" << std::setw( 18 ) << "metric"
+              << std::right << std::setw( 12 ) << "baseline" << std::setw( 12 ) << "current"
+              << std::setw( 10 ) << "change" << "  status\n";
+    for( auto& [key, values]: current ) {
+        const auto& [lib, op, contention, vars, threads] = key;
+        std::ostringstream point;
+        point << lib << " " << op << ( contention == "true"? "" : " (no contention)" )
+              << " vars=" << vars << " threads=" << threads;
+
+        const auto b = base.find( key );
+        if( b == base.end() ) {
+            std::cout << std::left << std::setw( 44 ) << point.str() << "no baseline\n";
+            continue;
+        }
+        for( auto& field: check_metadata ) {
+            const auto cur_it = values.find( field );
+            const auto base_it = b->second.find( field );
+            const auto cur_value = cur_it == values.end()? std::string( "?" ) : cur_it->second;
+            const auto base_value = base_it == b->second.end()? std::string( "?" ) : base_it->second;
+            if( cur_value != base_value ) {
+                std::cout << "Not comparable: the baseline was recorded with " << field << " " << base_value
+                          << ", the results with " << field << " " << cur_value << "\n";
+                return check_result::not_comparable;
+            }
+        }
+
+        for( auto& [metric, tolerance]: tolerances ) {
+            const auto cur_it = values.find( metric );
+            const auto base_it = b->second.find( metric );
+            if( cur_it == values.end() || base_it == b->second.end()
+                || cur_it->second == "null" || base_it->second == "null" )
+                continue;
+
+            const auto cur_value = std::stod( cur_it->second );
+            const auto base_value = std::stod( base_it->second );
+            if( metric == "throughput_mean" && b->second.count( "throughput_ci95" )
+                && b->second.at( "throughput_ci95" ) != "null"
+                && std::stod( b->second.at( "throughput_ci95" )) > tolerance / 2. * base_value ) {
+                std::cout << std::left << std::setw( 44 ) << point.str() << std::setw( 18 ) << metric
+                          << "baseline too noisy (ci95 " << b->second.at( "throughput_ci95" ) << ")\n";
+                continue;
+            }
+            const auto change = base_value != 0.? ( cur_value - base_value ) / base_value : 0.;
+            const auto worse = higher_is_better( metric )? -change : change;
+            const auto regressed = worse > tolerance;
+            n_regressions += regressed;
+            ++n_compared;
+
+            std::cout << std::left << std::setw( 44 ) << point.str() << std::setw( 18 ) << metric
+                      << std::right << std::setw( 12 ) << base_value << std::setw( 12 ) << cur_value
+                      << std::setw( 9 ) << std::fixed << std::setprecision( 1 ) << change*100. << "%"
+                      << std::defaultfloat << std::setprecision( 6 )
+                      << "  " << ( regressed? "REGRESSION" : "ok" ) << "\n";
+        }
+    }
+
+    std::cout << n_compared << " metric(s) compared, " << n_regressions << " regression(s)\n";
+    if( n_compared == 0 ) {
+        std::cout << "Not comparable: no metric of the results has a baseline\n";
+        return check_result::not_comparable;
+    }
+    return n_regressions? check_result::regressed : check_result::ok;
+}
+
+int main( int argc, char* argv[] ) {
+    std::vector<std::string> files;
+    std::string check_baseline;
+    std::map<std::string, double> tolerances;
+    for( auto i = 1; i < argc; ++i ) {
+        const auto s = std::string( argv[i] );
+
+        if( s == "-baseline" && i+1 < argc )
+            baseline = argv[++i];
+        else if( s == "-metric" && i+1 < argc )
+            metric = argv[++i];
+        else if( s == "-gnuplot" && i+1 < argc )
+            gnuplot_prefix = argv[++i];
+        else if( s == "-usl" )
+            fit_usl_curves = true;
+        else if( s == "-check" && i+1 < argc )
+            check_baseline = argv[++i];
+        else if( s == "-tolerance" && i+1 < argc ) {
+            const auto t = std::string( argv[++i] );
+            const auto eq = t.find( '=' );
+            if( eq == std::string::npos ) {
+                std::cerr << "Expected <metric>=<relative tolerance>: " << t << "\n";
+                exit( -1 );
+            }
+            tolerances[t.substr( 0, eq )] = std::stod( t.substr( eq+1 ));
+        }
+        else if( !s.empty() && s[0] == '-' ) {
+            std::cerr << "Unknown parameter: " << s << "\n";
+            exit( -1 );
+        }
+        else
+            files.push_back( s );
+    }
+    if( files.empty() ) {
+        std::cerr << "Usage: " << argv[0] << " [-baseline <library>] [-metric <name>] [-gnuplot <prefix>] [-usl] <results.jsonl>...\n"
+                  << "       " << argv[0] << " -check <baseline.jsonl> [-tolerance <metric>=<relative>]... <results.jsonl>...\n";
+        exit( -1 );
+    }
+
+    if( !check_baseline.empty() ) {
+        if( tolerances.empty() )
+            tolerances["throughput_mean"] = 0.25;
+        return int( check( check_baseline, files, tolerances ));
+    }
+
+    for( auto& f: files )
+        read_results( f );
+    for( auto& [e, points]: results ) {
+        report( e, points );
+        if( fit_usl_curves )
+            report_usl( e, points );
+    }
+}
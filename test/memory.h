@@ -0,0 +1,107 @@
+//
+// Memory usage of the process: resident set size and bytes in use by the allocator, sampled periodically by a
+// background thread if needed.
+//
+// Reading the bytes in use (mallinfo2) locks every malloc arena, so the sampler only reads them at its start and
+// stop and samples the resident set size (/proc/self/statm) in between.
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#if defined( __GLIBC__ )
+#include <malloc.h>
+#endif
+#include "topology.h"
+
+
+namespace jps {
+
+/*
+ * Resident set size in bytes (from /proc/self/statm); 0 if unavailable.
+ */
+inline size_t rss_bytes()
+{
+    std::ifstream statm( "/proc/self/statm" );
+    size_t total = 0, resident = 0;
+    if( !( statm >> total >> resident ))
+        return 0;
+    return resident * size_t( sysconf( _SC_PAGESIZE ));
+}
+
+/*
+ * Bytes handed out by malloc and not yet freed; 0 if unavailable. Unlike the resident set size, it shrinks as soon
+ * as objects are freed.
+ */
+inline size_t heap_in_use_bytes()
+{
+#if defined( __GLIBC__ ) && ( __GLIBC__ > 2 || __GLIBC_MINOR__ >= 33 )
+    const auto info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+struct memory_sample {
+    double ms;                          ///< since the start of the sampler
+    size_t rss;
+    std::optional<size_t> heap_in_use;  ///< of the first and the last sample only
+};
+
+/*
+ * Samples the memory usage every period from construction until stop(), on the given cpu if not negative.
+ */
+class memory_sampler {
+public:
+    explicit memory_sampler( std::chrono::milliseconds period, int cpu = -1 ) :
+            thread_( [this, period, cpu] {
+                if( cpu >= 0 && !pin_this_thread( cpu ))
+                    std::cerr << "Cannot pin the memory sampler to cpu " << cpu << "\n";
+                const auto start = std::chrono::steady_clock::now();
+                for( bool first = true;; first = false ) {
+                    const std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - start;
+                    const auto last = stop_.load( std::memory_order_acquire );
+                    samples_.push_back( { ms.count(), rss_bytes(), std::nullopt } );
+                    if( first || last )
+                        samples_.back().heap_in_use = heap_in_use_bytes();
+                    if( last )
+                        break;
+                    std::this_thread::sleep_for( period );
+                }
+            } )
+    {}
+    memory_sampler( const memory_sampler& ) = delete;
+    memory_sampler& operator=( const memory_sampler& ) = delete;
+    ~memory_sampler()
+    {
+        stop();
+    }
+
+    /*
+     * Stops sampling (after a last sample) and returns the samples.
+     */
+    const std::vector<memory_sample>& stop()
+    {
+        if( thread_.joinable() ) {
+            stop_.store( true, std::memory_order_release );
+            thread_.join();
+        }
+        return samples_;
+    }
+
+private:
+    std::vector<memory_sample> samples_;
+    std::atomic<bool> stop_{ false };
+    std::thread thread_;
+};
+
+}
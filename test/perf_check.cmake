@@ -0,0 +1,57 @@
+# Runs a short, pinned subset of measure (jps only, with contention; load, store, exchange and cas_strong; 1, 2, 4 and
+# all threads, never more threads than cpus; 1 and 64 vars) and compares the results against the baseline recorded
+# on this machine (MODE=check) or records the baseline (MODE=update).
+#
+# Only a Release build measures anything meaningful: the check is skipped for other builds and the update refused.
+# The check is also skipped without a baseline, or if the baseline was recorded on another machine or with other
+# flags (see measure_report -check).
+#
+# Expects MEASURE, MEASURE_REPORT, BASELINE, OUTPUT, BUILD_TYPE and MODE to be set via -D.
+
+if(NOT BUILD_TYPE STREQUAL "Release")
+	if(MODE STREQUAL "update")
+		message(FATAL_ERROR "The baseline must be recorded from a Release build, not '${BUILD_TYPE}'")
+	endif()
+	message(STATUS "perf_check skipped: needs a Release build (-DCMAKE_BUILD_TYPE=Release), not '${BUILD_TYPE}'")
+	return()
+endif()
+
+if(MODE STREQUAL "check" AND NOT EXISTS ${BASELINE})
+	message(STATUS "perf_check skipped: no baseline at ${BASELINE}; record one with the perf_baseline target")
+	return()
+endif()
+
+cmake_host_system_information(RESULT n_cpus QUERY NUMBER_OF_LOGICAL_CORES)
+set(workers ${n_cpus})
+foreach(w 1 2 4)
+	if(w LESS n_cpus)
+		list(APPEND workers ${w})
+	endif()
+endforeach()
+list(SORT workers COMPARE NATURAL)
+list(JOIN workers "," workers)
+
+file(REMOVE ${OUTPUT})
+execute_process(
+	COMMAND ${MEASURE} -default_lib +jps -default_op +load +store +exchange +cas_strong -no_contention
+		-workers ${workers} +workers ${n_cpus} -vars 1,64 -pin compact -warmup_ms 20 -trial_ms 100 -min_trials 3 -max_ms 600
+		-json ${OUTPUT}
+	RESULT_VARIABLE result
+	OUTPUT_QUIET)
+if(NOT result EQUAL 0)
+	message(FATAL_ERROR "measure failed: ${result}")
+endif()
+
+if(MODE STREQUAL "update")
+	configure_file(${OUTPUT} ${BASELINE} COPYONLY)
+	message(STATUS "Recorded ${BASELINE}")
+else()
+	execute_process(
+		COMMAND ${MEASURE_REPORT} -check ${BASELINE} -tolerance throughput_mean=0.25 ${OUTPUT}
+		RESULT_VARIABLE result)
+	if(result EQUAL 2)
+		message(STATUS "perf_check skipped: the results are not comparable with ${BASELINE}")
+	elseif(NOT result EQUAL 0)
+		message(FATAL_ERROR "Throughput regressed against ${BASELINE}")
+	endif()
+endif()
@@ -0,0 +1,145 @@
+//
+// Per-thread hardware performance counters via perf_event_open (Linux only).
+//
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace jps {
+
+struct perf_event_spec {
+    std::string name;
+    uint32_t type;
+    uint64_t config;
+};
+
+#ifdef __linux__
+inline constexpr uint64_t perf_hw_cache_config( uint64_t cache, uint64_t op, uint64_t result ) {
+    return cache | ( op << 8 ) | ( result << 16 );
+}
+
+inline std::vector<perf_event_spec> default_perf_events()
+{
+    return {
+            { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { "l1d_misses", PERF_TYPE_HW_CACHE, perf_hw_cache_config(
+                    PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS ) },
+            { "llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    };
+}
+/*
+ * Parses a raw, model-specific event "name=config", e.g., "hitm=0x04d2" for MEM_LOAD_L3_HIT_RETIRED.XSNP_HITM on
+ * Skylake (umask 0x04, event 0xd2). Cache line transfers between cores are only observable through such events.
+ */
+inline perf_event_spec parse_raw_perf_event( const std::string& s )
+{
+    const auto eq = s.find( '=' );
+    return { s.substr( 0, eq ), PERF_TYPE_RAW, std::stoull( s.substr( eq+1 ), nullptr, 0 ) };
+}
+#else
+inline std::vector<perf_event_spec> default_perf_events()
+{
+    return {};
+}
+inline perf_event_spec parse_raw_perf_event( const std::string& s )
+{
+    return { s, 0, 0 };
+}
+#endif
+
+/*
+ * A set of counters for the calling thread. Counters that cannot be opened (no permission, unsupported event, no
+ * Linux) are reported as unavailable instead of failing. enable() and disable() may be called from any thread.
+ */
+class perf_counters {
+public:
+    perf_counters() = default;
+    perf_counters( const perf_counters& ) = delete;
+    perf_counters& operator=( const perf_counters& ) = delete;
+    ~perf_counters()
+    {
+        close();
+    }
+
+    void open( const std::vector<perf_event_spec>& events )
+    {
+        close();
+#ifdef __linux__
+        for( auto& e: events ) {
+            perf_event_attr attr{};
+            attr.size = sizeof( attr );
+            attr.type = e.type;
+            attr.config = e.config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds_.push_back( int( syscall( SYS_perf_event_open, &attr, 0, -1, -1, 0 )));
+        }
+#else
+        fds_.assign( events.size(), -1 );
+#endif
+    }
+
+    void enable()
+    {
+#ifdef __linux__
+        for( auto fd: fds_ )
+            if( fd >= 0 )
+                ioctl( fd, PERF_EVENT_IOC_ENABLE, 0 );
+#endif
+    }
+    void disable()
+    {
+#ifdef __linux__
+        for( auto fd: fds_ )
+            if( fd >= 0 )
+                ioctl( fd, PERF_EVENT_IOC_DISABLE, 0 );
+#endif
+    }
+
+    /*
+     * The counter values, scaled up if the kernel multiplexed them; nullopt for unavailable counters.
+     */
+    std::vector<std::optional<double>> read() const
+    {
+        std::vector<std::optional<double>> values;
+        for( auto fd: fds_ ) {
+            values.emplace_back();
+#ifdef __linux__
+            uint64_t v[3];
+            if( fd >= 0 && ::read( fd, v, sizeof( v )) == sizeof( v ) && v[2] > 0 )
+                values.back() = double( v[0] ) * double( v[1] ) / double( v[2] );
+#endif
+        }
+        return values;
+    }
+
+private:
+    void close()
+    {
+#ifdef __linux__
+        for( auto fd: fds_ )
+            if( fd >= 0 )
+                ::close( fd );
+#endif
+        fds_.clear();
+    }
+
+    std::vector<int> fds_;
+};
+
+}
@@ -20,7 +20,9 @@ for L in "${BUFFER[@]}"; do
     A=(${L})
     case ${A[0]} in
         "===-operation:")
-            OP=${A[1]}
+            # e.g. load[stride=64] -> load_stride64, keeping the file names free of glob characters
+            OP=${A[1]//\[/_}
+            OP=${OP//[]=]/}
             OPS+=(${OP})
             FILEOUT=${PREFIX}-${OP}-${LIB}-${CONT}.txt
             ;;
@@ -43,6 +45,15 @@ for L in "${BUFFER[@]}"; do
         "===-lock_free:")
             ;;
 
+        "===-stride:")
+            ;;
+
+        "===-pinning:")
+            ;;
+
+        "===-harness_overhead:")
+            ;;
+
         "vars-threads")
             rm ${FILEOUT} 2>/dev/null
             echo "... writing ${FILEOUT}"
@@ -52,7 +63,8 @@ for L in "${BUFFER[@]}"; do
             ;;
 
         *)
-            echo "${L}" >> ${FILEOUT}
+            # keep the join key and the (mean) throughput only
+            echo "${A[0]} ${A[1]}" >> ${FILEOUT}
             ;;
     esac
 done
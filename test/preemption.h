@@ -0,0 +1,49 @@
+//
+// Injected preemption: at the preemption points inside the operations of the atomic shared pointers (the atomic
+// read-modify-writes of jps via JPS_ATOMIC_RMW_HOOK, the critical sections and hazard windows of the baselines via
+// JPS_BASELINE_PREEMPTION_HOOK) the calling thread gives up its cpu with a given probability.
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <sched.h>
+#include "random.h"
+
+
+namespace jps {
+
+struct preemption_injection {
+    double probability = 0.;    ///< per preemption point; 0 disables the injection
+    unsigned sleep_us = 0;      ///< sleep this long instead of sched_yield() if not 0
+};
+
+inline preemption_injection preemption;
+
+/*
+ * The slow path, kept out of line so that the preemption points inlined into every operation stay a single test.
+ * The generator is seeded from a counter: seeding it from its own address folds the seed constant into the TLS
+ * offset of the address, which overflows the relocation in optimized builds.
+ */
+[[gnu::noinline]] inline void preemption_roll() noexcept
+{
+    static std::atomic<uint64_t> seeds{ 0 };
+    static thread_local fast_rng rng{ seeds.fetch_add( 1, std::memory_order_relaxed ) };
+    if( rng.unit() >= preemption.probability )
+        return;
+    if( preemption.sleep_us )
+        std::this_thread::sleep_for( std::chrono::microseconds( preemption.sleep_us ));
+    else
+        sched_yield();
+}
+
+inline void preemption_point() noexcept
+{
+    if( preemption.probability > 0. )
+        preemption_roll();
+}
+
+}
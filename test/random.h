@@ -0,0 +1,114 @@
+//
+// Cheap per-thread random numbers for picking operations and targets inside the measured loop.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+namespace jps {
+
+/*
+ * xorshift64* seeded via splitmix64: a handful of instructions per number and no shared state.
+ */
+class fast_rng {
+public:
+    explicit fast_rng( uint64_t seed = 0 ) noexcept
+    {
+        uint64_t z = seed + 0x9e3779b97f4a7c15ull;
+        z = ( z ^ ( z >> 30 )) * 0xbf58476d1ce4e5b9ull;
+        z = ( z ^ ( z >> 27 )) * 0x94d049bb133111ebull;
+        state_ = ( z ^ ( z >> 31 )) | 1;
+    }
+
+    uint64_t operator()() noexcept
+    {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+        return state_ * 0x2545f4914f6cdd1dull;
+    }
+
+    /*
+     * Uniform in [0, n) (multiply-shift; the bias is negligible for the small n used here).
+     */
+    size_t below( size_t n ) noexcept
+    {
+        return size_t(( __uint128_t(( *this )()) * n ) >> 64 );
+    }
+
+    /*
+     * Uniform in [0, 1).
+     */
+    double unit() noexcept
+    {
+        return double(( *this )() >> 11 ) * 0x1.0p-53;
+    }
+
+private:
+    uint64_t state_;
+};
+
+/*
+ * Picks an index in [0, n): uniformly, or with probability proportional to 1/(k+1)^s for zipf:s (index 0 is the
+ * hottest). Sampling is a binary search in the precomputed cumulative distribution.
+ */
+class target_distribution {
+public:
+    target_distribution() = default;
+    target_distribution( size_t n, double zipf_s ) :
+            n_( n ),
+            zipf_( zipf_s > 0. )
+    {
+        if( !zipf_ )
+            return;
+        cdf_.resize( n );
+        double sum = 0.;
+        for( auto k = 0u; k < n; ++k )
+            cdf_[k] = sum += 1. / std::pow( double( k+1 ), zipf_s );
+        for( auto& c: cdf_ )
+            c /= sum;
+    }
+
+    size_t operator()( fast_rng& rng ) const noexcept
+    {
+        if( !zipf_ )
+            return rng.below( n_ );
+        const auto it = std::lower_bound( cdf_.begin(), cdf_.end(), rng.unit() );
+        return std::min( size_t( it - cdf_.begin() ), n_-1 );
+    }
+
+private:
+    size_t n_ = 1;
+    bool zipf_ = false;
+    std::vector<double> cdf_;
+};
+
+/*
+ * Parses "uniform" or "zipf:<s>" into the exponent s (0 for uniform); nullopt if unknown or if s is not a finite,
+ * non-negative number.
+ */
+inline std::optional<double> parse_distribution( const std::string& spec )
+{
+    if( spec == "uniform" )
+        return 0.;
+    if( spec.rfind( "zipf:", 0 ) != 0 || spec.size() == 5 )
+        return std::nullopt;
+    const auto begin = spec.c_str()+5;
+    char* end;
+    const auto zipf_s = std::strtod( begin, &end );
+    if( std::isspace( static_cast<unsigned char>( *begin )) || *end != '\0' || !std::isfinite( zipf_s ) || zipf_s < 0. )
+        return std::nullopt;
+    return zipf_s;
+}
+
+}
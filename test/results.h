@@ -0,0 +1,233 @@
+//
+// Machine-readable results of measure: JSON lines and (long format) CSV with the metadata of the run, and a reader
+// for the JSON lines used by measure_report.
+//
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+#include "statistics.h"
+
+#ifndef MEASURE_CXX_FLAGS
+#define MEASURE_CXX_FLAGS "unknown"
+#endif
+#if __has_include( "measure_git_commit.h" )
+#include "measure_git_commit.h"   // generated on every build by test/git_commit.cmake
+#endif
+#ifndef MEASURE_GIT_COMMIT
+#define MEASURE_GIT_COMMIT "unknown"
+#endif
+
+
+namespace jps {
+
+struct run_metadata {
+    std::string host;
+    std::string cpu_model;
+    size_t n_cpus;
+    std::string compiler;
+    std::string flags;
+    std::string commit;
+    std::string pinning;
+};
+
+inline run_metadata collect_metadata( const std::string& pinning )
+{
+    run_metadata m;
+
+    char host[256] = {};
+    gethostname( host, sizeof( host )-1 );
+    m.host = host;
+
+    m.cpu_model = "unknown";
+    std::ifstream cpuinfo( "/proc/cpuinfo" );
+    for( std::string line; std::getline( cpuinfo, line ); ) {
+        if( line.rfind( "model name", 0 ) == 0 ) {
+            const auto colon = line.find( ':' );
+            m.cpu_model = line.substr( line.find_first_not_of( ' ', colon+1 ));
+            break;
+        }
+    }
+    m.n_cpus = std::thread::hardware_concurrency();
+
+#if defined( __clang__ )
+    m.compiler = "clang " __clang_version__;
+#elif defined( __GNUC__ )
+    m.compiler = "gcc " __VERSION__;
+#else
+    m.compiler = "unknown";
+#endif
+    m.flags = MEASURE_CXX_FLAGS;
+    m.commit = MEASURE_GIT_COMMIT;
+    m.pinning = pinning;
+    return m;
+}
+
+/*
+ * The result of one point of a sweep. Additional metrics (latency percentiles, hardware events per operation, ...)
+ * are kept in the order they were measured; nullopt marks an unavailable value.
+ */
+struct point_record {
+    std::string library;
+    std::string operation;
+    bool contention;
+    size_t vars;
+    size_t threads;
+    sample_stats throughput;    ///< ops/us
+    std::vector<std::pair<std::string, std::optional<double>>> metrics;
+};
+
+inline std::string json_escape( const std::string& s )
+{
+    std::string r;
+    for( auto c: s ) {
+        if( c == '"' || c == '\\' )
+            r += '\\';
+        if( static_cast<unsigned char>( c ) >= 0x20 )
+            r += c;
+    }
+    return r;
+}
+
+/*
+ * A CSV field in double quotes, with the quotes in it doubled.
+ */
+inline std::string csv_quote( const std::string& s )
+{
+    std::string q = "\"";
+    for( auto c: s )
+        q += c == '"'? std::string( "\"\"" ) : std::string( 1, c );
+    return q + "\"";
+}
+
+/*
+ * Writes one self-contained JSON object per line.
+ */
+inline void write_json( std::ostream& out, const run_metadata& m, const point_record& r )
+{
+    const auto number = [&]( std::optional<double> v ) {
+        if( v && std::isfinite( *v ))
+            out << *v;
+        else
+            out << "null";
+    };
+
+    out << "{\"host\":\"" << json_escape( m.host )
+        << "\",\"cpu_model\":\"" << json_escape( m.cpu_model )
+        << "\",\"n_cpus\":" << m.n_cpus
+        << ",\"compiler\":\"" << json_escape( m.compiler )
+        << "\",\"flags\":\"" << json_escape( m.flags )
+        << "\",\"commit\":\"" << json_escape( m.commit )
+        << "\",\"pinning\":\"" << json_escape( m.pinning )
+        << "\",\"library\":\"" << json_escape( r.library )
+        << "\",\"operation\":\"" << json_escape( r.operation )
+        << "\",\"contention\":" << ( r.contention? "true" : "false" )
+        << ",\"vars\":" << r.vars
+        << ",\"threads\":" << r.threads
+        << ",\"throughput_mean\":";
+    number( r.throughput.mean );
+    out << ",\"throughput_median\":";
+    number( r.throughput.median );
+    out << ",\"throughput_ci95\":";
+    number( r.throughput.ci95 );
+    out << ",\"trials\":" << r.throughput.n;
+    for( auto& [name, value]: r.metrics ) {
+        out << ",\"" << json_escape( name ) << "\":";
+        number( value );
+    }
+    out << "}" << std::endl;
+}
+
+/*
+ * Writes one row per metric (long format), which keeps the columns fixed whatever metrics were measured.
+ */
+inline void write_csv_header( std::ostream& out )
+{
+    out << "host,cpu_model,n_cpus,compiler,flags,commit,pinning,library,operation,contention,vars,threads,metric,value\n";
+}
+inline void write_csv( std::ostream& out, const run_metadata& m, const point_record& r )
+{
+    std::ostringstream prefix;
+    prefix << csv_quote( m.host ) << "," << csv_quote( m.cpu_model ) << "," << m.n_cpus << ","
+           << csv_quote( m.compiler ) << "," << csv_quote( m.flags ) << "," << csv_quote( m.commit ) << ","
+           << csv_quote( m.pinning ) << "," << csv_quote( r.library ) << "," << csv_quote( r.operation ) << ","
+           << ( r.contention? "true" : "false" ) << "," << r.vars << "," << r.threads << ",";
+
+    const auto row = [&]( const std::string& name, std::optional<double> value ) {
+        out << prefix.str() << csv_quote( name ) << ",";
+        if( value && std::isfinite( *value ))
+            out << *value;
+        out << "\n";
+    };
+    row( "throughput_mean", r.throughput.mean );
+    row( "throughput_median", r.throughput.median );
+    row( "throughput_ci95", r.throughput.ci95 );
+    row( "trials", double( r.throughput.n ));
+    for( auto& [name, value]: r.metrics )
+        row( name, value );
+    out.flush();
+}
+
+/*
+ * Parses one line written by write_json() into its (unescaped) values; numbers, booleans and null are kept as text.
+ */
+inline std::map<std::string, std::string> parse_json_line( const std::string& line )
+{
+    std::map<std::string, std::string> values;
+    size_t i = 0;
+    const auto skip_ws = [&] {
+        while( i < line.size() && ( line[i] == ' ' || line[i] == '\t' ))
+            ++i;
+    };
+    const auto read_string = [&] {
+        std::string s;
+        for( ++i; i < line.size() && line[i] != '"'; ++i ) {
+            if( line[i] == '\\' && i+1 < line.size() )
+                ++i;
+            s += line[i];
+        }
+        ++i;
+        return s;
+    };
+
+    skip_ws();
+    if( i >= line.size() || line[i] != '{' )
+        return values;
+    ++i;
+    for(;;) {
+        skip_ws();
+        if( i >= line.size() || line[i] != '"' )
+            break;
+        const auto key = read_string();
+        skip_ws();
+        if( i >= line.size() || line[i] != ':' )
+            break;
+        ++i;
+        skip_ws();
+        if( i < line.size() && line[i] == '"' )
+            values[key] = read_string();
+        else {
+            const auto end = line.find_first_of( ",}", i );
+            values[key] = line.substr( i, end-i );
+            i = end;
+        }
+        skip_ws();
+        if( i >= line.size() || line[i] != ',' )
+            break;
+        ++i;
+    }
+    return values;
+}
+
+}
@@ -0,0 +1,329 @@
+//
+// Asserts the exact number of atomic read-modify-write operations per (uncontended) pointer operation.
+//
+// The throughput of the algorithm depends on the number of RMWs on the hot path, e.g., a load costs two fetch_adds.
+// Every RMW of atomic_paired_counter, atomic_counted_ptr and of the destruction state of shareable is counted via
+// JPS_ATOMIC_RMW_HOOK, so any change in the number of RMWs fails here instead of showing up as a throughput regression.
+//
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace {
+thread_local size_t rmw_count = 0;
+}
+
+#define JPS_ATOMIC_RMW_HOOK() ( ++rmw_count )
+#include "shared_ptr.h"
+
+
+struct test {
+    test( uint64_t u ) : u{ u }
+    {}
+    uint64_t u;
+};
+
+using sptr = jps::shared_ptr<test>;
+using wptr = jps::weak_ptr<test>;
+using asptr = jps::atomic_shared_ptr<test>;
+
+size_t n_failed = 0;
+
+/*
+ * Runs setup() uncounted, then op() counted, and compares the number of RMWs done by op() with the expected number.
+ */
+template<class Setup, class Operation>
+void expect_rmw( const char* name, size_t expected, Setup setup, Operation op )
+{
+    auto state = setup();
+    rmw_count = 0;
+    op( state );
+    const auto counted = rmw_count;
+
+    if( counted != expected ) {
+        ++n_failed;
+        std::cout << "FAILED: " << name << ": expected " << expected << " RMWs, counted " << counted << "\n";
+    }
+    else
+        std::cout << "ok: " << name << ": " << counted << " RMWs\n";
+}
+
+/*
+ * State of a test case, i.e. the objects the measured operation works on. They are destroyed uncounted after the
+ * operation unless the operation destroys them itself.
+ */
+struct state {
+    sptr s1;
+    sptr s2;
+    wptr w1;
+    wptr w2;
+    asptr a1;
+};
+
+auto empty()
+{
+    return []{ return std::make_unique<state>(); };
+}
+auto with_sptr()
+{
+    return []{
+        auto s = std::make_unique<state>();
+        s->s1 = sptr{ new test{ 1 }};
+        return s;
+    };
+}
+auto with_two_sptrs()
+{
+    return []{
+        auto s = std::make_unique<state>();
+        s->s1 = sptr{ new test{ 1 }};
+        s->s2 = sptr{ new test{ 2 }};
+        return s;
+    };
+}
+auto with_shared_sptr()
+{
+    return []{
+        auto s = std::make_unique<state>();
+        s->s1 = sptr{ new test{ 1 }};
+        s->s2 = s->s1;
+        return s;
+    };
+}
+auto with_wptr()
+{
+    return []{
+        auto s = std::make_unique<state>();
+        s->s1 = sptr{ new test{ 1 }};
+        s->w1 = s->s1;
+        return s;
+    };
+}
+auto with_expired_wptr()
+{
+    return []{
+        auto s = std::make_unique<state>();
+        s->s1 = sptr{ new test{ 1 }};
+        s->w1 = s->s1;
+        s->s1.reset();
+        return s;
+    };
+}
+auto with_asptr()
+{
+    return []{
+        auto s = std::make_unique<state>();
+        s->a1.store( sptr{ new test{ 1 }});
+        return s;
+    };
+}
+auto with_asptr_and_sptr()
+{
+    return []{
+        auto s = std::make_unique<state>();
+        s->a1.store( sptr{ new test{ 1 }});
+        s->s1 = sptr{ new test{ 2 }};
+        return s;
+    };
+}
+auto with_asptr_and_expected()
+{
+    return []{
+        auto s = std::make_unique<state>();
+        s->a1.store( sptr{ new test{ 1 }});
+        s->s1 = s->a1.load();
+        s->s2 = sptr{ new test{ 2 }};
+        return s;
+    };
+}
+
+void test_shared_ptr()
+{
+    expect_rmw( "shared_ptr()", 0, empty(), []( auto& ) { sptr p; } );
+    expect_rmw( "shared_ptr( T* )", 0, empty(), []( auto& s ) { s->s1 = sptr{ new test{ 1 }}; } );
+    expect_rmw( "make_shared", 0, empty(), []( auto& s ) { s->s1 = jps::make_shared<test>( 1 ); } );
+    expect_rmw( "shared_ptr( const shared_ptr& )", 1, with_sptr(), []( auto& s ) { new( &s->s2 ) sptr{ s->s1 }; } );
+    expect_rmw( "shared_ptr( shared_ptr&& )", 0, with_sptr(), []( auto& s ) { sptr p{ std::move( s->s1 ) }; std::swap( p, s->s2 ); } );
+    expect_rmw( "~shared_ptr() (shared)", 1, with_shared_sptr(), []( auto& s ) { s->s1.~sptr(); new( &s->s1 ) sptr; } );
+    expect_rmw( "~shared_ptr() (last)", 1, with_sptr(), []( auto& s ) { s->s1.~sptr(); new( &s->s1 ) sptr; } );
+    expect_rmw( "~make_shared() (last)", 1, []{
+        auto s = std::make_unique<state>();
+        s->s1 = jps::make_shared<test>( 1 );
+        return s;
+    }, []( auto& s ) { s->s1.~sptr(); new( &s->s1 ) sptr; } );
+    expect_rmw( "shared_ptr = const shared_ptr&", 2, with_two_sptrs(), []( auto& s ) { s->s2 = s->s1; } );
+    expect_rmw( "shared_ptr = shared_ptr&&", 0, with_two_sptrs(), []( auto& s ) { s->s2 = std::move( s->s1 ); } );
+    expect_rmw( "shared_ptr::reset()", 1, with_sptr(), []( auto& s ) { s->s1.reset(); } );
+    expect_rmw( "shared_ptr::operator->", 0, with_sptr(), []( auto& s ) { s->s1->u++; } );
+    expect_rmw( "shared_ptr::use_count", 0, with_sptr(), []( auto& s ) { (void) s->s1.use_count(); } );
+}
+
+/*
+ * Returns the memory of a shareable to the global operator delete after it destroyed itself.
+ */
+struct delete_shareable {
+    template<class P>
+    void operator()( P* p ) const noexcept
+    {
+        ::operator delete( static_cast<void*>( p ));
+    }
+};
+
+auto with_shareable()
+{
+    return []{
+        auto s = std::make_unique<state>();
+        delete_shareable d;
+        s->s1 = *new jps::shareable<test, delete_shareable>{ d, 1 };
+        return s;
+    };
+}
+auto with_shareable_and_wptr()
+{
+    return []{
+        auto s = std::make_unique<state>();
+        delete_shareable d;
+        s->s1 = *new jps::shareable<test, delete_shareable>{ d, 1 };
+        s->w1 = s->s1;
+        return s;
+    };
+}
+auto with_expired_shareable_wptr()
+{
+    return []{
+        auto s = std::make_unique<state>();
+        delete_shareable d;
+        s->s1 = *new jps::shareable<test, delete_shareable>{ d, 1 };
+        s->w1 = s->s1;
+        s->s1.reset();
+        return s;
+    };
+}
+
+void test_shareable()
+{
+    expect_rmw( "shareable -> shared_ptr", 0, empty(), []( auto& s ) {
+        delete_shareable d;
+        s->s1 = *new jps::shareable<test, delete_shareable>{ d, 1 };
+    } );
+    expect_rmw( "~shared_ptr() (last; shareable)", 4, with_shareable(), []( auto& s ) { s->s1.~sptr(); new( &s->s1 ) sptr; } );
+    expect_rmw( "~shared_ptr() (last, weak_ptr left; shareable)", 3, with_shareable_and_wptr(), []( auto& s ) { s->s1.~sptr(); new( &s->s1 ) sptr; } );
+    expect_rmw( "~weak_ptr() (last; shareable)", 2, with_expired_shareable_wptr(), []( auto& s ) { s->w1.~wptr(); new( &s->w1 ) wptr; } );
+}
+
+void test_weak_ptr()
+{
+    expect_rmw( "weak_ptr( const shared_ptr& )", 1, with_sptr(), []( auto& s ) { new( &s->w1 ) wptr{ s->s1 }; } );
+    expect_rmw( "weak_ptr( const weak_ptr& )", 1, with_wptr(), []( auto& s ) { new( &s->w2 ) wptr{ s->w1 }; } );
+    expect_rmw( "weak_ptr = const weak_ptr&", 1, with_wptr(), []( auto& s ) { s->w2 = s->w1; } );
+    expect_rmw( "~weak_ptr()", 1, with_wptr(), []( auto& s ) { s->w1.~wptr(); new( &s->w1 ) wptr; } );
+    expect_rmw( "weak_ptr::lock() (alive)", 1, with_wptr(), []( auto& s ) { auto p = s->w1.lock(); std::swap( p, s->s2 ); } );
+    expect_rmw( "weak_ptr::lock() (expired)", 0, with_expired_wptr(), []( auto& s ) { (void) s->w1.lock(); } );
+    expect_rmw( "weak_ptr::expired()", 0, with_wptr(), []( auto& s ) { (void) s->w1.expired(); } );
+}
+
+void test_atomic_shared_ptr()
+{
+    expect_rmw( "atomic_shared_ptr::load() (null)", 1, empty(), []( auto& s ) { (void) s->a1.load(); } );
+    expect_rmw( "atomic_shared_ptr::load()", 2, with_asptr(), []( auto& s ) { s->s1 = s->a1.load(); } );
+    expect_rmw( "atomic_shared_ptr::store( shared_ptr&& ) (null)", 1, with_sptr(), []( auto& s ) { s->a1.store( std::move( s->s1 )); } );
+    expect_rmw( "atomic_shared_ptr::store( shared_ptr&& )", 1, with_asptr_and_sptr(), []( auto& s ) { s->a1.store( std::move( s->s1 )); } );
+    expect_rmw( "atomic_shared_ptr::store( const shared_ptr& )", 3, with_asptr_and_sptr(), []( auto& s ) { s->a1.store( s->s1 ); } );
+    expect_rmw( "atomic_shared_ptr::exchange( shared_ptr&& )", 1, with_asptr_and_sptr(), []( auto& s ) { s->s2 = s->a1.exchange( std::move( s->s1 )); } );
+    expect_rmw( "atomic_shared_ptr::exchange( const shared_ptr& )", 2, with_asptr_and_sptr(), []( auto& s ) { s->s2 = s->a1.exchange( s->s1 ); } );
+    expect_rmw( "atomic_shared_ptr::compare_exchange_strong( && ) (success)", 2, with_asptr_and_expected(), []( auto& s ) {
+        if( !s->a1.compare_exchange_strong( s->s1, std::move( s->s2 )))
+            rmw_count += 1000;
+    } );
+    expect_rmw( "atomic_shared_ptr::compare_exchange_strong( && ) (failure)", 3, with_asptr_and_sptr(), []( auto& s ) {
+        sptr expected{ new test{ 3 }};
+        std::swap( expected, s->s2 );
+        if( s->a1.compare_exchange_strong( s->s2, std::move( s->s1 )))
+            rmw_count += 1000;
+    } );
+    expect_rmw( "atomic_shared_ptr::compare_exchange_strong( const& ) (success)", 4, with_asptr_and_expected(), []( auto& s ) {
+        if( !s->a1.compare_exchange_strong( s->s1, s->s2 ))
+            rmw_count += 1000;
+    } );
+    expect_rmw( "atomic_shared_ptr::compare_exchange_strong( const& ) (failure)", 3, with_asptr_and_sptr(), []( auto& s ) {
+        sptr expected{ new test{ 3 }};
+        std::swap( expected, s->s2 );
+        if( s->a1.compare_exchange_strong( s->s2, s->s1 ))
+            rmw_count += 1000;
+    } );
+    expect_rmw( "atomic_shared_ptr::compare_exchange_weak( && ) (success)", 2, with_asptr_and_expected(), []( auto& s ) {
+        if( !s->a1.compare_exchange_weak( s->s1, std::move( s->s2 )))
+            rmw_count += 1000;
+    } );
+    expect_rmw( "atomic_shared_ptr::compare_exchange_weak( && ) (failure)", 3, with_asptr_and_sptr(), []( auto& s ) {
+        sptr expected{ new test{ 3 }};
+        std::swap( expected, s->s2 );
+        if( s->a1.compare_exchange_weak( s->s2, std::move( s->s1 )))
+            rmw_count += 1000;
+    } );
+    expect_rmw( "atomic_shared_ptr::compare_exchange_weak( const& ) (success)", 4, with_asptr_and_expected(), []( auto& s ) {
+        if( !s->a1.compare_exchange_weak( s->s1, s->s2 ))
+            rmw_count += 1000;
+    } );
+    expect_rmw( "atomic_shared_ptr::compare_exchange_weak( const& ) (failure)", 3, with_asptr_and_sptr(), []( auto& s ) {
+        sptr expected{ new test{ 3 }};
+        std::swap( expected, s->s2 );
+        if( s->a1.compare_exchange_weak( s->s2, s->s1 ))
+            rmw_count += 1000;
+    } );
+    expect_rmw( "atomic_shared_ptr::wait() (changed; copies old)", 4, with_asptr_and_sptr(), []( auto& s ) { s->a1.wait( s->s1 ); } );
+    expect_rmw( "atomic_shared_ptr::notify_all()", 0, with_asptr(), []( auto& s ) { s->a1.notify_all(); } );
+    expect_rmw( "~atomic_shared_ptr()", 1, with_asptr(), []( auto& s ) { s->a1.~asptr(); new( &s->a1 ) asptr; } );
+}
+
+/*
+ * wait() blocks until another thread stores a different value and notifies; checked with a deadline since a lost
+ * wake-up would block forever.
+ */
+void test_wait_notify()
+{
+    asptr a;
+    const sptr old{ new test{ 1 }};
+    a.store( old );
+    std::atomic<bool> woken{ false };
+    std::thread waiter( [&] {
+        a.wait( old );
+        woken.store( true );
+    } );
+
+    std::this_thread::sleep_for( std::chrono::milliseconds( 10 ));
+    a.store( sptr{ new test{ 2 }} );
+    a.notify_all();
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds( 5 );
+    while( !woken.load() && std::chrono::steady_clock::now() < deadline )
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ));
+    if( !woken.load() ) {
+        std::cout << "FAILED: atomic_shared_ptr::wait() did not return after store and notify_all()\n";
+        std::exit( 1 );     // the waiter cannot be joined
+    }
+    waiter.join();
+    std::cout << "ok: atomic_shared_ptr::wait() returns after store and notify_all()\n";
+}
+
+int main()
+{
+    test_shared_ptr();
+    test_weak_ptr();
+    test_shareable();
+    test_atomic_shared_ptr();
+    test_wait_notify();
+
+    if( n_failed ) {
+        std::cout << n_failed << " test(s) failed\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+//
+// Summary statistics of repeated measurements.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+
+namespace jps {
+
+/*
+ * Two-sided 95% quantile of Student's t-distribution for the given degrees of freedom.
+ */
+inline double student_t_95( size_t df )
+{
+    static constexpr double table[] = {
+            0., 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+            2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+            2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+    if( df < std::size( table ))
+        return table[df];
+    return df < 60? 2.000 : df < 120? 1.980 : 1.960;
+}
+
+struct sample_stats {
+    size_t n = 0;
+    double mean = 0.;
+    double median = 0.;
+    double stddev = 0.;
+    double ci95 = 0.;       ///< half width of the 95% confidence interval of the mean
+
+    /*
+     * The half width of the confidence interval relative to the mean.
+     */
+    double relative_ci95() const
+    {
+        return mean != 0.? ci95 / std::abs( mean ) : 0.;
+    }
+};
+
+inline sample_stats summarize( std::vector<double> samples )
+{
+    sample_stats s;
+    s.n = samples.size();
+    if( s.n == 0 )
+        return s;
+
+    for( auto x: samples )
+        s.mean += x;
+    s.mean /= double( s.n );
+
+    std::sort( samples.begin(), samples.end() );
+    s.median = s.n % 2? samples[s.n/2] : ( samples[s.n/2-1] + samples[s.n/2] ) / 2.;
+
+    if( s.n > 1 ) {
+        double sum_sq = 0.;
+        for( auto x: samples )
+            sum_sq += ( x-s.mean ) * ( x-s.mean );
+        s.stddev = std::sqrt( sum_sq / double( s.n-1 ));
+        s.ci95 = student_t_95( s.n-1 ) * s.stddev / std::sqrt( double( s.n ));
+    }
+    return s;
+}
+
+struct fairness_stats {
+    double min_max_ratio = 1.;  ///< least over most operations of any worker
+    double cv = 0.;             ///< coefficient of variation (population standard deviation / mean)
+    double jain = 1.;           ///< Jain's index ( sum x )^2 / ( n * sum x^2 ), 1/n (unfair) to 1 (fair)
+};
+
+/*
+ * How evenly the work was shared given the number of operations of each worker.
+ */
+inline fairness_stats fairness( const std::vector<double>& per_worker )
+{
+    fairness_stats f;
+    if( per_worker.empty() )
+        return f;
+
+    const auto [min, max] = std::minmax_element( per_worker.begin(), per_worker.end() );
+    double sum = 0., sum_sq = 0.;
+    for( auto x: per_worker ) {
+        sum += x;
+        sum_sq += x*x;
+    }
+    const auto n = double( per_worker.size() );
+    const auto mean = sum / n;
+
+    f.min_max_ratio = *max > 0.? *min / *max : 1.;
+    f.cv = mean > 0.? std::sqrt( std::max( sum_sq/n - mean*mean, 0. )) / mean : 0.;
+    f.jain = sum_sq > 0.? sum*sum / ( n*sum_sq ) : 1.;
+    return f;
+}
+
+}
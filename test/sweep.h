@@ -0,0 +1,96 @@
+//
+// Grids of the swept parameters and a checkpoint file to resume an interrupted sweep.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+namespace jps {
+
+/*
+ * Returns first, first+1, ..., last (linear) or first, 2*first, 4*first, ..., last (geometric, always ending in last).
+ */
+inline std::vector<size_t> make_grid( size_t first, size_t last, bool geometric )
+{
+    std::vector<size_t> grid;
+    for( auto x = first; x <= last; x = geometric? std::max( 2*x, x+1 ) : x+1 )
+        grid.push_back( x );
+    if( geometric && !grid.empty() && grid.back() != last )
+        grid.push_back( last );
+    return grid;
+}
+
+/*
+ * Parses a custom grid like "1,2,4,8,16,32,48"; nullopt if it is empty or has a value that is not a number or is
+ * below min.
+ */
+inline std::optional<std::vector<size_t>> parse_grid( const std::string& list, size_t min = 1 )
+{
+    std::vector<size_t> grid;
+    std::stringstream ss( list );
+    std::string value;
+    while( std::getline( ss, value, ',' )) {
+        if( value.empty() )
+            continue;
+        size_t x;
+        const auto end = value.data() + value.size();
+        const auto [ptr, ec] = std::from_chars( value.data(), end, x );
+        if( ec != std::errc() || ptr != end || x < min )
+            return std::nullopt;
+        grid.push_back( x );
+    }
+    if( grid.empty() )
+        return std::nullopt;
+    return grid;
+}
+
+/*
+ * Stores the output row of each finished point of a sweep, keyed by everything identifying the point, one per
+ * line. Opening an existing file loads the finished points, so that a resumed sweep can skip (and re-print) them.
+ */
+class sweep_checkpoint {
+public:
+    sweep_checkpoint() = default;
+    explicit sweep_checkpoint( const std::string& path )
+    {
+        std::ifstream in( path );
+        std::string line;
+        while( std::getline( in, line )) {
+            const auto sep = line.find( '|' );
+            if( sep != std::string::npos )
+                rows_[line.substr( 0, sep )] = line.substr( sep+1 );
+        }
+        out_.open( path, std::ios::app );
+    }
+
+    std::optional<std::string> find( const std::string& key ) const
+    {
+        const auto it = rows_.find( key );
+        if( it == rows_.end() )
+            return std::nullopt;
+        return it->second;
+    }
+
+    void record( const std::string& key, const std::string& row )
+    {
+        rows_[key] = row;
+        if( out_.is_open() )
+            out_ << key << '|' << row << std::endl;
+    }
+
+private:
+    std::map<std::string, std::string> rows_;
+    std::ofstream out_;
+};
+
+}
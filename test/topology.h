@@ -0,0 +1,201 @@
+//
+// CPU topology (as reported by /sys/devices/system/cpu) and thread placement policies for the experiments.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+
+
+namespace jps {
+
+struct cpu_info {
+    int cpu;
+    int core;
+    int package;
+    int l3;         ///< id of the last level cache domain
+    int smt_rank;   ///< index of this cpu among the hardware threads of its core
+};
+
+/*
+ * Parses a cpu list like "0-3,8,10-11"; throws std::invalid_argument if it is malformed.
+ */
+inline std::vector<int> parse_cpu_list( const std::string& list )
+{
+    const auto parse_cpu = [&]( const std::string& s ) {
+        size_t end = 0;
+        int cpu = -1;
+        if( !s.empty() && std::isdigit( static_cast<unsigned char>( s[0] )))
+            try {
+                cpu = std::stoi( s, &end );
+            } catch( const std::out_of_range& ) {}
+        if( cpu < 0 || cpu >= CPU_SETSIZE || end != s.size() )
+            throw std::invalid_argument( "invalid cpu list: " + list );
+        return cpu;
+    };
+
+    std::vector<int> cpus;
+    std::stringstream ss( list );
+    std::string range;
+    while( std::getline( ss, range, ',' )) {
+        if( range.empty() )
+            continue;
+        const auto dash = range.find( '-' );
+        const auto first = parse_cpu( range.substr( 0, dash ));
+        const auto last = dash == std::string::npos? first : parse_cpu( range.substr( dash+1 ));
+        if( last < first )
+            throw std::invalid_argument( "invalid cpu list: " + list );
+        for( auto c = first; c <= last; ++c )
+            cpus.push_back( c );
+    }
+    return cpus;
+}
+
+inline std::vector<cpu_info> read_cpu_topology()
+{
+    const std::string base = "/sys/devices/system/cpu/";
+    const auto read_int = [&]( const std::string& file, int fallback ) {
+        std::ifstream in( base + file );
+        int value;
+        return ( in >> value )? value : fallback;
+    };
+
+    std::string online;
+    std::ifstream( base + "online" ) >> online;
+    auto cpus = parse_cpu_list( online );
+    if( cpus.empty() )
+        for( auto c = 0u; c < std::thread::hardware_concurrency(); ++c )
+            cpus.push_back( int( c ));
+
+    std::vector<cpu_info> topology;
+    for( auto c: cpus ) {
+        const auto dir = "cpu" + std::to_string( c ) + "/";
+        const auto package = read_int( dir + "topology/physical_package_id", 0 );
+        topology.push_back( {
+                c,
+                read_int( dir + "topology/core_id", c ),
+                package,
+                read_int( dir + "cache/index3/id", package ),
+                0 } );
+    }
+
+    // rank the hardware threads of each core
+    std::map<std::tuple<int, int>, int> n_threads_per_core;
+    for( auto& ci: topology )
+        ci.smt_rank = n_threads_per_core[{ ci.package, ci.core }]++;
+
+    return topology;
+}
+
+/*
+ * Whether the process may run on the given cpu (it is online and in the affinity mask of the process).
+ */
+inline bool cpu_available( int cpu )
+{
+    cpu_set_t set;
+    CPU_ZERO( &set );
+    return cpu >= 0 && cpu < CPU_SETSIZE && sched_getaffinity( 0, sizeof( set ), &set ) == 0 && CPU_ISSET( cpu, &set );
+}
+
+/*
+ * Returns the order in which workers are pinned to cpus:
+ *  - smt-first: fill all hardware threads of a core, then the next core of the same cache domain and package
+ *  - compact:   one worker per core of a cache domain and package, then the next domain; SMT siblings last
+ *  - scatter:   one worker per core, round-robin over cache domains and packages; SMT siblings last
+ *  - list:      the given cpu list, e.g. "0,2,4-7"
+ * The policies other than list only use the cpus the process may run on.
+ * Returns an empty vector for an unknown policy; throws std::invalid_argument for a malformed list.
+ */
+inline std::vector<int> placement( const std::string& policy, const std::string& list = {} )
+{
+    if( policy == "list" )
+        return parse_cpu_list( list );
+
+    auto topology = read_cpu_topology();
+    std::erase_if( topology, []( const cpu_info& c ) { return !cpu_available( c.cpu ); } );
+    const auto domain = []( const cpu_info& c ) { return std::make_tuple( c.package, c.l3 ); };
+
+    if( policy == "smt-first" )
+        std::sort( topology.begin(), topology.end(), [&]( const auto& a, const auto& b ) {
+            return std::make_tuple( domain( a ), a.core, a.smt_rank ) < std::make_tuple( domain( b ), b.core, b.smt_rank );
+        } );
+    else if( policy == "compact" )
+        std::sort( topology.begin(), topology.end(), [&]( const auto& a, const auto& b ) {
+            return std::make_tuple( a.smt_rank, domain( a ), a.core ) < std::make_tuple( b.smt_rank, domain( b ), b.core );
+        } );
+    else if( policy == "scatter" ) {
+        // index of each cpu within its domain (for the same smt rank) determines the round
+        std::sort( topology.begin(), topology.end(), [&]( const auto& a, const auto& b ) {
+            return std::make_tuple( a.smt_rank, domain( a ), a.core ) < std::make_tuple( b.smt_rank, domain( b ), b.core );
+        } );
+        std::map<std::tuple<int, int, int>, int> n_per_domain;
+        std::vector<std::tuple<int, int, int, int>> order;   // smt rank, round, domain, cpu
+        for( auto& c: topology ) {
+            const auto round = n_per_domain[{ c.smt_rank, c.package, c.l3 }]++;
+            order.emplace_back( c.smt_rank, round, c.package * 65536 + c.l3, c.cpu );
+        }
+        std::sort( order.begin(), order.end() );
+
+        std::vector<int> cpus;
+        for( auto& o: order )
+            cpus.push_back( std::get<3>( o ));
+        return cpus;
+    }
+    else
+        return {};
+
+    std::vector<int> cpus;
+    for( auto& c: topology )
+        cpus.push_back( c.cpu );
+    return cpus;
+}
+
+/*
+ * Returns an available cpu not in busy, preferring the last one; -1 if there is none.
+ */
+inline int free_cpu( const std::vector<int>& busy )
+{
+    const auto topology = read_cpu_topology();
+    for( auto c = topology.rbegin(); c != topology.rend(); ++c )
+        if( std::find( busy.begin(), busy.end(), c->cpu ) == busy.end() && cpu_available( c->cpu ))
+            return c->cpu;
+    return -1;
+}
+
+/*
+ * Pins the calling thread to the given cpu; returns false if that failed (e.g., the cpu is not available).
+ */
+inline bool pin_this_thread( int cpu )
+{
+    cpu_set_t set;
+    CPU_ZERO( &set );
+    CPU_SET( cpu, &set );
+    return pthread_setaffinity_np( pthread_self(), sizeof( set ), &set ) == 0;
+}
+
+/*
+ * Pins a worker thread to the given cpu, aborting if that failed: the results of a measurement that claims a
+ * placement it did not get are meaningless.
+ */
+inline void pin_worker( size_t worker_id, int cpu )
+{
+    if( !pin_this_thread( cpu )) {
+        std::cerr << "Cannot pin worker " << worker_id << " to cpu " << cpu << "\n";
+        std::abort();
+    }
+}
+
+}
@@ -0,0 +1,272 @@
+//
+// Operation traces of atomic shared pointers: a recording wrapper logs every operation with its time, slot and
+// object size per thread, and the recorder writes the traces to a compact binary file that measure can replay
+// (-replay).
+//
+// File layout (native endianness): the magic "JPSTRC01", the number of threads and of slots (uint32_t each), then
+// per thread the number of events (uint64_t) followed by the events.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace jps {
+
+enum class trace_op : uint8_t { load, store, exchange, cas_weak, cas_strong };
+
+constexpr const char* trace_op_names[] = { "load", "store", "exchange", "cas_weak", "cas_strong" };
+
+/*
+ * 16 bytes per operation: the size of the object stored (0 for loads and null pointers) shares a word with the
+ * operation, so sizes of max_size and beyond are recorded as max_size.
+ */
+struct trace_event {
+    uint64_t ns;            ///< since the start of the recording
+    uint32_t slot;
+    uint32_t size_op;       ///< size << 4 | op
+
+    static constexpr uint32_t max_size = ( uint32_t( 1 ) << 28 ) - 1;
+
+    trace_op op() const noexcept
+    {
+        return trace_op( size_op & 0xf );
+    }
+    uint32_t size() const noexcept
+    {
+        return size_op >> 4;
+    }
+};
+static_assert( sizeof( trace_event ) == 16 );
+
+struct trace {
+    uint32_t n_slots = 0;
+    std::vector<std::vector<trace_event>> threads;
+};
+
+/*
+ * Collects the events of all threads in per-thread buffers (appended to without synchronization) and writes them
+ * to the file on write() or destruction; the destructor reports a failure to write on stderr instead of throwing.
+ */
+class trace_recorder {
+public:
+    explicit trace_recorder( std::string path ) :
+            path_( std::move( path )),
+            start_( std::chrono::steady_clock::now() ),
+            id_( _next_id().fetch_add( 1, std::memory_order_relaxed ))
+    {}
+    trace_recorder( const trace_recorder& ) = delete;
+    trace_recorder& operator=( const trace_recorder& ) = delete;
+    ~trace_recorder()
+    {
+        if( written_ )
+            return;
+        try {
+            write();
+        }
+        catch( const std::exception& e ) {
+            std::cerr << e.what() << "\n";
+        }
+    }
+
+    void record( trace_op op, uint32_t slot, size_t size )
+    {
+        const std::chrono::duration<uint64_t, std::nano> ns = std::chrono::steady_clock::now() - start_;
+        const auto clamped = uint32_t( std::min<size_t>( size, trace_event::max_size ));
+        _local().push_back( { ns.count(), slot, clamped << 4 | uint32_t( op ) } );
+    }
+
+    /*
+     * Writes the traces recorded so far; the threads must not record meanwhile.
+     */
+    void write()
+    {
+        std::lock_guard lock( mutex_ );
+        uint32_t n_slots = 0;
+        for( auto& b: buffers_ )
+            for( auto& e: *b )
+                n_slots = std::max( n_slots, e.slot+1 );
+
+        std::ofstream out( path_, std::ios::binary | std::ios::trunc );
+        const uint32_t n_threads = uint32_t( buffers_.size() );
+        out.write( "JPSTRC01", 8 );
+        out.write( reinterpret_cast<const char*>( &n_threads ), sizeof( n_threads ));
+        out.write( reinterpret_cast<const char*>( &n_slots ), sizeof( n_slots ));
+        for( auto& b: buffers_ ) {
+            const uint64_t n_events = b->size();
+            out.write( reinterpret_cast<const char*>( &n_events ), sizeof( n_events ));
+            out.write( reinterpret_cast<const char*>( b->data() ), std::streamsize( n_events * sizeof( trace_event )));
+        }
+        if( !out )
+            throw std::runtime_error( "cannot write trace " + path_ );
+        written_ = true;
+    }
+
+private:
+    /*
+     * Recorders are told apart by id rather than address: a recorder created where a destroyed one was must not
+     * find the buffer of its predecessor.
+     */
+    static std::atomic<uint64_t>& _next_id()
+    {
+        static std::atomic<uint64_t> next{ 1 };
+        return next;
+    }
+
+    /*
+     * The buffer of the calling thread, one per thread and recorder even if the thread records with several
+     * recorders in turn. The entries of destroyed recorders stay behind but are never found again.
+     */
+    std::vector<trace_event>& _local()
+    {
+        struct entry {
+            uint64_t recorder;
+            std::vector<trace_event>* buffer;
+        };
+        static thread_local std::vector<entry> buffers;
+        if( !buffers.empty() && buffers.back().recorder == id_ ) [[likely]]
+            return *buffers.back().buffer;
+
+        // move the entry of this recorder to the back, so that the next call finds it first
+        const auto it = std::find_if( buffers.begin(), buffers.end(),
+                                      [this]( const entry& e ) { return e.recorder == id_; } );
+        if( it == buffers.end() ) {
+            std::lock_guard lock( mutex_ );
+            buffers_.push_back( std::make_unique<std::vector<trace_event>>() );
+            buffers.push_back( { id_, buffers_.back().get() } );
+        }
+        else
+            std::rotate( it, it+1, buffers.end() );
+        return *buffers.back().buffer;
+    }
+
+    std::string path_;
+    std::chrono::steady_clock::time_point start_;
+    const uint64_t id_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<std::vector<trace_event>>> buffers_;
+    bool written_ = false;
+};
+
+/*
+ * Reads a trace written by trace_recorder; throws std::runtime_error if the file is not a trace, is truncated or
+ * holds events of unknown operations or of slots beyond the number of slots.
+ */
+inline trace read_trace( const std::string& path )
+{
+    std::ifstream in( path, std::ios::binary | std::ios::ate );
+    const auto file_size = uint64_t( std::max<std::streamoff>( in.tellg(), 0 ));
+    in.seekg( 0 );
+    char magic[8];
+    uint32_t n_threads = 0;
+    trace t;
+    in.read( magic, sizeof( magic ));
+    in.read( reinterpret_cast<char*>( &n_threads ), sizeof( n_threads ));
+    in.read( reinterpret_cast<char*>( &t.n_slots ), sizeof( t.n_slots ));
+    if( !in || std::memcmp( magic, "JPSTRC01", 8 ) != 0 )
+        throw std::runtime_error( "not a trace: " + path );
+
+    // every count is checked against the rest of the file before allocating for it
+    auto remaining = file_size - uint64_t( in.tellg() );
+    if( n_threads > remaining / sizeof( uint64_t ))
+        throw std::runtime_error( "truncated trace: " + path );
+    t.threads.resize( n_threads );
+    for( auto& events: t.threads ) {
+        uint64_t n_events = 0;
+        in.read( reinterpret_cast<char*>( &n_events ), sizeof( n_events ));
+        remaining -= sizeof( n_events );
+        if( !in || n_events > remaining / sizeof( trace_event ))
+            throw std::runtime_error( "truncated trace: " + path );
+        events.resize( n_events );
+        in.read( reinterpret_cast<char*>( events.data() ), std::streamsize( n_events * sizeof( trace_event )));
+        remaining -= n_events * sizeof( trace_event );
+        for( auto& e: events )
+            if( e.slot >= t.n_slots || e.op() > trace_op::cas_strong )
+                throw std::runtime_error( "invalid event in trace: " + path );
+    }
+    if( !in )
+        throw std::runtime_error( "truncated trace: " + path );
+    return t;
+}
+
+/*
+ * An atomic shared pointer (jps::atomic_shared_ptr, std::atomic<std::shared_ptr>, ...) that records each of its
+ * operations as the given slot, with the size of the element type as object size.
+ */
+template<class ASPTR>
+class recording_atomic_shared_ptr {
+public:
+    using value_type = decltype( std::declval<const ASPTR&>().load() );
+
+    recording_atomic_shared_ptr( trace_recorder& recorder, uint32_t slot ) :
+            recorder_( recorder ),
+            slot_( slot )
+    {}
+    recording_atomic_shared_ptr( const recording_atomic_shared_ptr& ) = delete;
+    recording_atomic_shared_ptr& operator=( const recording_atomic_shared_ptr& ) = delete;
+
+    value_type load( std::memory_order order = std::memory_order_seq_cst ) const
+    {
+        recorder_.record( trace_op::load, slot_, 0 );
+        return asp_.load( order );
+    }
+    void store( value_type desired, std::memory_order order = std::memory_order_seq_cst )
+    {
+        recorder_.record( trace_op::store, slot_, _size( desired ));
+        asp_.store( std::move( desired ), order );
+    }
+    value_type exchange( value_type desired, std::memory_order order = std::memory_order_seq_cst )
+    {
+        recorder_.record( trace_op::exchange, slot_, _size( desired ));
+        return asp_.exchange( std::move( desired ), order );
+    }
+    bool compare_exchange_weak( value_type& expected, value_type desired,
+                                std::memory_order success, std::memory_order failure )
+    {
+        recorder_.record( trace_op::cas_weak, slot_, _size( desired ));
+        return asp_.compare_exchange_weak( expected, std::move( desired ), success, failure );
+    }
+    bool compare_exchange_weak( value_type& expected, value_type desired,
+                                std::memory_order order = std::memory_order_seq_cst )
+    {
+        recorder_.record( trace_op::cas_weak, slot_, _size( desired ));
+        return asp_.compare_exchange_weak( expected, std::move( desired ), order );
+    }
+    bool compare_exchange_strong( value_type& expected, value_type desired,
+                                  std::memory_order success, std::memory_order failure )
+    {
+        recorder_.record( trace_op::cas_strong, slot_, _size( desired ));
+        return asp_.compare_exchange_strong( expected, std::move( desired ), success, failure );
+    }
+    bool compare_exchange_strong( value_type& expected, value_type desired,
+                                  std::memory_order order = std::memory_order_seq_cst )
+    {
+        recorder_.record( trace_op::cas_strong, slot_, _size( desired ));
+        return asp_.compare_exchange_strong( expected, std::move( desired ), order );
+    }
+
+private:
+    static size_t _size( const value_type& p ) noexcept
+    {
+        return p? sizeof( *p ) : 0;
+    }
+
+    trace_recorder& recorder_;
+    const uint32_t slot_;
+    ASPTR asp_;
+};
+
+}
@@ -0,0 +1,173 @@
+//
+// Records operations with recording_atomic_shared_ptr, reads the trace back and checks every event; also checks that
+// a recorder created where a destroyed one was starts with empty buffers, that a thread alternating between two
+// recorders gets one buffer per recorder, that oversized objects are clamped and that read_trace rejects malformed
+// files. Leaves the recorded trace at the given path for measure -replay (see the trace_replay test).
+//
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "shared_ptr.h"
+#include "trace.h"
+
+
+struct test {
+    test( uint64_t u ) : u{ u }
+    {}
+    uint64_t u;
+};
+
+using sptr = jps::shared_ptr<test>;
+using recording_asptr = jps::recording_atomic_shared_ptr<jps::atomic_shared_ptr<test>>;
+
+size_t n_failed = 0;
+
+void expect( const std::string& name, bool ok )
+{
+    if( !ok ) {
+        ++n_failed;
+        std::cout << "FAILED: " << name << "\n";
+    }
+    else
+        std::cout << "ok: " << name << "\n";
+}
+
+/*
+ * Each thread does the same 5 operations on its own slot (thread t on slot t).
+ */
+void record( jps::trace_recorder& recorder, size_t n_threads )
+{
+    std::vector<std::optional<recording_asptr>> slots( n_threads );
+    for( auto t = 0u; t < n_threads; ++t )
+        slots[t].emplace( recorder, t );
+
+    std::vector<std::thread> threads;
+    for( auto t = 0u; t < n_threads; ++t ) {
+        threads.emplace_back( [&, t] {
+            auto& asp = *slots[t];
+            asp.store( sptr{ new test{ 1 }} );
+            auto expected = asp.load();
+            asp.compare_exchange_strong( expected, sptr{ new test{ 2 }} );
+            asp.compare_exchange_weak( expected, sptr{} );
+            (void) asp.exchange( sptr{ new test{ 3 }} );
+        } );
+    }
+    for( auto& t: threads )
+        t.join();
+}
+
+bool rejected( const std::string& path )
+{
+    try {
+        (void) jps::read_trace( path );
+    }
+    catch( const std::runtime_error& ) {
+        return true;
+    }
+    return false;
+}
+
+void write_header( std::ofstream& out, uint32_t n_threads, uint32_t n_slots )
+{
+    out.write( "JPSTRC01", 8 );
+    out.write( reinterpret_cast<const char*>( &n_threads ), sizeof( n_threads ));
+    out.write( reinterpret_cast<const char*>( &n_slots ), sizeof( n_slots ));
+}
+
+int main( int argc, char* argv[] )
+{
+    const std::string path = argc > 1? argv[1] : "roundtrip.trace";
+    constexpr size_t n_threads = 2;
+
+    std::optional<jps::trace_recorder> recorder;
+    recorder.emplace( path );
+    record( *recorder, n_threads );
+    recorder.reset();
+
+    const auto t = jps::read_trace( path );
+    expect( "number of slots and threads", t.n_slots == n_threads && t.threads.size() == n_threads );
+    const jps::trace_op ops[] = { jps::trace_op::store, jps::trace_op::load, jps::trace_op::cas_strong,
+                                  jps::trace_op::cas_weak, jps::trace_op::exchange };
+    const uint32_t sizes[] = { sizeof( test ), 0, sizeof( test ), 0, sizeof( test ) };
+    for( auto& events: t.threads ) {
+        bool ok = events.size() == std::size( ops );
+        for( auto i = 0u; ok && i < events.size(); ++i )
+            ok = events[i].op() == ops[i] && events[i].size() == sizes[i] && events[i].slot == events[0].slot
+                 && ( i == 0 || events[i].ns >= events[i-1].ns );
+        expect( "events of slot " + std::to_string( events.empty()? 0 : events[0].slot ), ok );
+    }
+
+    // this thread records with two recorders in turn at the same address
+    const auto second_path = path + ".second";
+    for( auto& p: { path + ".first", second_path } ) {
+        recorder.emplace( p );
+        recording_asptr asp( *recorder, 0 );
+        (void) asp.load();
+        recorder.reset();
+    }
+    const auto second = jps::read_trace( second_path );
+    expect( "recorder at the address of a destroyed one",
+            second.threads.size() == 1 && second.threads[0].size() == 1 );
+
+    // this thread alternates between two live recorders
+    {
+        std::optional<jps::trace_recorder> first, second;
+        first.emplace( path + ".first" );
+        second.emplace( second_path );
+        recording_asptr a( *first, 0 ), b( *second, 0 );
+        for( auto i = 0; i < 3; ++i ) {
+            (void) a.load();
+            (void) b.load();
+        }
+        first->record( jps::trace_op::store, 0, size_t( 1 ) << 40 );
+        first.reset();
+        second.reset();
+    }
+    const auto alternating = jps::read_trace( path + ".first" );
+    expect( "one buffer per thread and recorder",
+            alternating.threads.size() == 1 && alternating.threads[0].size() == 4
+            && jps::read_trace( second_path ).threads.size() == 1 );
+    expect( "oversized object clamped",
+            alternating.threads.size() == 1 && alternating.threads[0].back().size() == jps::trace_event::max_size
+            && alternating.threads[0].back().op() == jps::trace_op::store );
+
+    const auto bad_path = path + ".bad";
+    {
+        std::ofstream out( bad_path, std::ios::binary | std::ios::trunc );
+        write_header( out, 1, 1 );
+        const uint64_t n_events = uint64_t( 1 ) << 60;
+        out.write( reinterpret_cast<const char*>( &n_events ), sizeof( n_events ));
+    }
+    expect( "read_trace rejects a huge event count", rejected( bad_path ));
+    {
+        std::ofstream out( bad_path, std::ios::binary | std::ios::trunc );
+        write_header( out, 1, 1 );
+        const uint64_t n_events = 1;
+        const jps::trace_event e{ 0, 1, uint32_t( jps::trace_op::load ) };
+        out.write( reinterpret_cast<const char*>( &n_events ), sizeof( n_events ));
+        out.write( reinterpret_cast<const char*>( &e ), sizeof( e ));
+    }
+    expect( "read_trace rejects an event beyond the slots", rejected( bad_path ));
+    expect( "read_trace rejects a missing file", rejected( path + ".missing" ));
+
+    // a recorder that cannot write reports it instead of terminating
+    recorder.emplace( path + ".missing/trace" );
+    {
+        recording_asptr asp( *recorder, 0 );
+        (void) asp.load();
+    }
+    recorder.reset();
+    expect( "destructor of a recorder that cannot write", true );
+
+    if( n_failed ) {
+        std::cout << n_failed << " test(s) failed\n";
+        return 1;
+    }
+    return 0;
+}
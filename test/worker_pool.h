@@ -0,0 +1,113 @@
+//
+// A pool of persistent (optionally pinned) threads reused by consecutive experiments.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "topology.h"
+
+
+namespace jps {
+
+class worker_pool {
+public:
+    /*
+     * Thread i of the pool is pinned to cpus[i % cpus.size()] (aborting if that fails); an empty list leaves the
+     * placement to the scheduler.
+     */
+    explicit worker_pool( std::vector<int> cpus = {} ) :
+            cpus_( std::move( cpus ))
+    {}
+    worker_pool( const worker_pool& ) = delete;
+    worker_pool& operator=( const worker_pool& ) = delete;
+    ~worker_pool()
+    {
+        {
+            std::lock_guard lock( mutex_ );
+            stop_ = true;
+        }
+        start_cv_.notify_all();
+        for( auto& t: threads_ )
+            t.join();
+    }
+
+    size_t size() const noexcept
+    {
+        return threads_.size();
+    }
+
+    /*
+     * Runs job( i ) on the threads 0 <= i < n of the pool, growing the pool if needed, and returns immediately.
+     * Call wait() before the next start().
+     */
+    void start( size_t n, std::function<void( size_t )> job )
+    {
+        while( threads_.size() < n ) {
+            const auto id = threads_.size();
+            threads_.emplace_back( [this, id, seen = generation_] { _work( id, seen ); } );
+        }
+
+        {
+            std::lock_guard lock( mutex_ );
+            job_ = std::move( job );
+            n_active_ = n;
+            pending_ = n;
+            ++generation_;
+        }
+        start_cv_.notify_all();
+    }
+
+    /*
+     * Waits until all threads have finished the job given to start().
+     */
+    void wait()
+    {
+        std::unique_lock lock( mutex_ );
+        done_cv_.wait( lock, [this] { return pending_ == 0; } );
+    }
+
+private:
+    void _work( size_t id, uint64_t seen )
+    {
+        if( !cpus_.empty() )
+            pin_worker( id, cpus_[id % cpus_.size()] );
+
+        for(;;) {
+            std::unique_lock lock( mutex_ );
+            start_cv_.wait( lock, [&] { return stop_ || generation_ != seen; } );
+            if( stop_ )
+                return;
+            seen = generation_;
+            if( id >= n_active_ )
+                continue;
+            lock.unlock();
+
+            job_( id );
+
+            lock.lock();
+            if( --pending_ == 0 )
+                done_cv_.notify_all();
+        }
+    }
+
+    std::vector<int> cpus_;
+    std::vector<std::thread> threads_;
+
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    std::function<void( size_t )> job_;
+    size_t n_active_ = 0;
+    size_t pending_ = 0;
+    uint64_t generation_ = 0;
+    bool stop_ = false;
+};
+
+}